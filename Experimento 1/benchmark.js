@@ -0,0 +1,85 @@
+importPackage(java.io);
+
+// =============================================================================================================
+// tempo ate a solucao e numero de mensagens da descoberta de rotas (uma linha de CSV por execucao)
+// parametros: -Dbench.label=<motor> -Dbench.output=<csv> -Dbench.limit=<s> -Dbench.settle=<s>
+// =============================================================================================================
+
+function param(name, value) {
+    var v = java.lang.System.getProperty("bench." + name);
+    return v == null ? value : "" + v;
+}
+
+var LABEL = param("label", "dfs");
+var OUTPUT = param("output", "benchmark.csv");
+var LIMIT = parseInt(param("limit", "1800")) * 1000000;
+var SETTLE = parseInt(param("settle", "30")) * 1000;
+
+var KINDS = ["mistT%Q0C3R", "mistT%Q0C5R", "fogT%Q0C15R", "fogT%Q0C20R", "cloudT%Q5C200R", "cloudT%Q10C250R"];
+
+sim.setSpeedLimit(null);
+var motes = sim.getMotes();
+
+var i = 0;
+while (i < motes.length) {
+    YIELD();
+    if (msg.startsWith("Starting")) {
+        i++;
+    }
+}
+
+// mesmos perfis do cenario.js, repetidos para os motes excedentes
+write(motes[0], "DT" + motes.length + "Q0C0R");
+for (i = 1; i < motes.length; i++) {
+    write(motes[i], KINDS[(i - 1) % KINDS.length].replace("%", motes.length));
+}
+
+var t0 = time;
+var solution = "";
+var solved = -1;
+
+// o Bellman-Ford pode anunciar solucoes melhores depois da primeira: vale a ultima ate SETTLE sem novidades
+while (time - t0 < LIMIT) {
+    YIELD();
+
+    if (msg.contains("Finished")) {
+        solution = msg.trim();
+        solved = (time - t0) / 1000;
+        GENERATE_MSG(SETTLE, "settle" + solved);
+    }
+
+    if (solved >= 0 && msg.equals("settle" + solved)) {
+        break;
+    }
+}
+
+for (i = 0; i < motes.length; i++) {
+    write(motes[i], "S");
+}
+
+var messages = 0;
+var answered = 0;
+while (answered < motes.length) {
+    YIELD();
+    if (msg.startsWith("Messages -> ")) {
+        messages += parseInt(msg.substring(12));
+        answered++;
+    }
+}
+
+var file = new File(OUTPUT);
+var header = !file.exists();
+var writer = new FileWriter(file, true);
+
+if (header) {
+    writer.write("label,motes,seed,time_to_solution_ms,messages,solution\n");
+}
+
+var line = LABEL + "," + motes.length + "," + sim.getRandomSeed() + "," + solved + "," + messages +
+    ",\"" + solution.replace(/"/g, "'") + "\"\n";
+
+writer.write(line);
+writer.close();
+
+log.log(line);
+log.testOK();
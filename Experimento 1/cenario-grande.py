@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+# =============================================================================================================
+# gera uma simulacao do Cooja com centenas de motes (ids acima de 255) para a descoberta de rotas
+#
+# uso: cenario-grande.py [motes] [espacamento_m] [motor] > cenario-grande.csc
+#
+# motes do tipo Cooja (nativos) numa grade, DEVICE_D (id 1) no centro, UDGM com alcance de 50 m: com o
+# espacamento padrao cada vertice tem ate 8 vizinhos. O benchmark.js roda no Script Editor e grava uma
+# linha em benchmark.csv quando DEVICE_D imprime "Finished"
+# =============================================================================================================
+
+import math
+import sys
+
+RANGE = 50.0
+
+# a tabela estatica so cobre os ids 1..16: acima disso a latencia vem das sondas, e o requisito vai em ms
+FIRMWARE = ("make firmware.cooja TARGET=cooja MAXIMUM_DEVICES=%d MAXIMUM_HOPS=24 "
+            "LINK_LATENCY_MAX_NEIGHBORS=24 LATENCY_SOURCE=1 LATENCY_REQUIREMENT=250 DISCOVERY_ENGINE=%d")
+
+INTERFACES = [
+    "org.contikios.cooja.interfaces.Position",
+    "org.contikios.cooja.interfaces.Battery",
+    "org.contikios.cooja.contikimote.interfaces.ContikiVib",
+    "org.contikios.cooja.contikimote.interfaces.ContikiMoteID",
+    "org.contikios.cooja.contikimote.interfaces.ContikiRS232",
+    "org.contikios.cooja.contikimote.interfaces.ContikiBeeper",
+    "org.contikios.cooja.interfaces.RimeAddress",
+    "org.contikios.cooja.contikimote.interfaces.ContikiIPAddress",
+    "org.contikios.cooja.contikimote.interfaces.ContikiRadio",
+    "org.contikios.cooja.contikimote.interfaces.ContikiButton",
+    "org.contikios.cooja.contikimote.interfaces.ContikiPIR",
+    "org.contikios.cooja.contikimote.interfaces.ContikiClock",
+    "org.contikios.cooja.contikimote.interfaces.ContikiLED",
+    "org.contikios.cooja.contikimote.interfaces.ContikiCFS",
+    "org.contikios.cooja.interfaces.Mote2MoteRelations",
+    "org.contikios.cooja.interfaces.MoteAttributes",
+]
+
+
+def grid(motes, spacing):
+    # posicoes em espiral quadrada a partir do centro, para que o id 1 fique no meio da grade
+    positions = [(0, 0)]
+    x = y = 0
+    step = 1
+
+    while len(positions) < motes:
+        for dx, dy, count in ((1, 0, step), (0, 1, step), (-1, 0, step + 1), (0, -1, step + 1)):
+            for _ in range(count):
+                x += dx
+                y += dy
+                positions.append((x, y))
+        step += 2
+
+    return [(px * spacing, py * spacing) for px, py in positions[:motes]]
+
+
+def main():
+    motes = int(sys.argv[1]) if len(sys.argv) > 1 else 320
+    spacing = float(sys.argv[2]) if len(sys.argv) > 2 else 35.0
+    engine = int(sys.argv[3]) if len(sys.argv) > 3 else 1
+
+    if motes < 2 or motes > 65535:
+        sys.exit("motes fora de 2..65535: %d" % motes)
+
+    if spacing > RANGE:
+        sys.exit("espacamento %.1f m maior que o alcance de %.1f m: grade desconexa" % (spacing, RANGE))
+
+    devices = 1 << max(5, math.ceil(math.log2(motes + 1)))
+
+    out = sys.stdout
+    out.write('<?xml version="1.0" encoding="UTF-8"?>\n<simconf>\n  <simulation>\n')
+    out.write("    <title>Descoberta de rotas com %d motes</title>\n" % motes)
+    out.write("    <randomseed>123456</randomseed>\n    <motedelay_us>1000000</motedelay_us>\n")
+    out.write("    <radiomedium>\n      org.contikios.cooja.radiomediums.UDGM\n")
+    out.write("      <transmitting_range>%.1f</transmitting_range>\n" % RANGE)
+    out.write("      <interference_range>%.1f</interference_range>\n" % (2 * RANGE))
+    out.write("      <success_ratio_tx>1.0</success_ratio_tx>\n      <success_ratio_rx>1.0</success_ratio_rx>\n")
+    out.write("    </radiomedium>\n    <events>\n      <logoutput>40000</logoutput>\n    </events>\n")
+
+    out.write("    <motetype>\n      org.contikios.cooja.contikimote.ContikiMoteType\n")
+    out.write("      <identifier>mtype1</identifier>\n      <description>firmware</description>\n")
+    out.write("      <source>[CONFIG_DIR]/firmware.c</source>\n")
+    out.write("      <commands>%s</commands>\n" % (FIRMWARE % (devices, engine)))
+    for interface in INTERFACES:
+        out.write("      <moteinterface>%s</moteinterface>\n" % interface)
+    out.write("      <symbols>false</symbols>\n    </motetype>\n")
+
+    for mote, (x, y) in enumerate(grid(motes, spacing), 1):
+        out.write("    <mote>\n      <interface_config>\n        org.contikios.cooja.interfaces.Position\n")
+        out.write("        <x>%.1f</x>\n        <y>%.1f</y>\n        <z>0.0</z>\n" % (x, y))
+        out.write("      </interface_config>\n      <interface_config>\n")
+        out.write("        org.contikios.cooja.contikimote.interfaces.ContikiMoteID\n")
+        out.write("        <id>%d</id>\n      </interface_config>\n" % mote)
+        out.write("      <motetype_identifier>mtype1</motetype_identifier>\n    </mote>\n")
+
+    out.write("  </simulation>\n  <plugin>\n    org.contikios.cooja.plugins.ScriptRunner\n    <plugin_config>\n")
+    out.write("      <scriptfile>[CONFIG_DIR]/benchmark.js</scriptfile>\n      <active>true</active>\n")
+    out.write("    </plugin_config>\n  </plugin>\n</simconf>\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,76 @@
+#include "discovery-frame.h"
+
+#include <string.h>
+
+// =============================================================================================================
+
+static void put16(uint8_t *buffer, uint16_t value)
+{
+  buffer[0] = value & 0xff;
+  buffer[1] = value >> 8;
+}
+
+static uint16_t get16(const uint8_t *buffer)
+{
+  return buffer[0] | (uint16_t)buffer[1] << 8;
+}
+
+// =============================================================================================================
+
+int frame_encode(const struct discovery_frame *frame, uint8_t *buffer)
+{
+
+  int i;
+
+  buffer[0] = frame->title;
+  buffer[1] = frame->request;
+  buffer[2] = frame->kind;
+  buffer[3] = frame->resource;
+
+  put16(buffer + 4, frame->latency);
+  put16(buffer + 6, frame->requirement);
+  put16(buffer + 8, frame->budget);
+  put16(buffer + 10, frame->price);
+
+  put16(buffer + 12, frame->link[0]);
+  put16(buffer + 14, frame->link[1]);
+  buffer[16] = frame->route.length;
+
+  for (i = 0; i < frame->route.length; i++)
+    put16(buffer + FRAME_HEADER_SIZE + 2 * i, frame->route.hop[i]);
+
+  return FRAME_HEADER_SIZE + 2 * frame->route.length;
+}
+
+// =============================================================================================================
+
+int frame_decode(const uint8_t *buffer, int length, struct discovery_frame *frame)
+{
+
+  int i;
+
+  if (length < FRAME_HEADER_SIZE || buffer[16] > MAXIMUM_HOPS || length != FRAME_HEADER_SIZE + 2 * buffer[16])
+    return 0;
+
+  frame->title = buffer[0];
+  frame->request = buffer[1];
+  frame->kind = buffer[2];
+  frame->resource = buffer[3];
+
+  frame->latency = get16(buffer + 4);
+  frame->requirement = get16(buffer + 6);
+  frame->budget = get16(buffer + 8);
+  frame->price = get16(buffer + 10);
+
+  frame->link[0] = get16(buffer + 12);
+  frame->link[1] = get16(buffer + 14);
+
+  // o bitmap de visitados nao vai no ar: e refeito a partir dos saltos
+  path_clear(&frame->route);
+
+  for (i = 0; i < buffer[16]; i++)
+    if (!path_append(&frame->route, get16(buffer + FRAME_HEADER_SIZE + 2 * i)))
+      return 0;
+
+  return 1;
+}
@@ -0,0 +1,33 @@
+#ifndef DISCOVERY_FRAME_H
+#define DISCOVERY_FRAME_H
+
+#include "route-path.h"
+
+// =============================================================================================================
+// quadro de descoberta no ar: cabecalho fixo (little-endian) seguido so dos saltos usados do caminho
+//
+//   0 title | 1 request | 2 kind | 3 resource | 4-5 latency | 6-7 requirement | 8-9 budget | 10-11 price |
+//   12-15 link | 16 length | 17... hop[length], 2 bytes cada
+//
+// budget, nos broadcasts, e o que resta do requisito depois de latency: o receptor descarta o quadro se o
+// enlace pelo qual chegou ja nao cabe nele
+// =============================================================================================================
+
+#define FRAME_HEADER_SIZE 17
+#define FRAME_MAX_SIZE (FRAME_HEADER_SIZE + 2 * MAXIMUM_HOPS)
+
+struct discovery_frame
+{
+  uint8_t title, request, kind, resource;
+  uint16_t latency, requirement, budget, price;
+  node_id_t link[2];
+  struct path route;
+};
+
+// escreve o quadro em buffer (FRAME_MAX_SIZE bytes) e retorna o tamanho
+int frame_encode(const struct discovery_frame *frame, uint8_t *buffer);
+
+// 0 quando o tamanho nao bate com o caminho ou algum salto e invalido
+int frame_decode(const uint8_t *buffer, int length, struct discovery_frame *frame);
+
+#endif
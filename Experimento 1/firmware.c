@@ -10,17 +10,94 @@
 #include "contiki-conf.h"
 #include "lib/list.h"
 
+#include "route-path.h"
+#include "route-cost.h"
+#include "pareto.h"
+#include "link-latency.h"
+#include "route-cache.h"
+#include "discovery-frame.h"
+#include "latency-table.h"
+#include "hop-cost.h"
+
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include <math.h>
 #include <stdint.h>
 
 // =============================================================================================================
 
-#define MAXIMUM_DEVICES 30
+// COST_BENCHMARK=1 (make COST_BENCHMARK=1) mede os ciclos do custo em ponto fixo contra o double no alvo
+#ifndef COST_BENCHMARK
+#define COST_BENCHMARK 0
+#endif
+#define COST_BENCHMARK_ROUNDS 100
+
+// origem da latencia dos enlaces: so a tabela estatica ou so as sondas com EWMA (enlace sem amostra fica de fora)
+//
+// as unidades diferem: a tabela esta nas unidades abstratas em que LATENCY_REQUIREMENT foi calibrado, as
+// sondas medem meia ida e volta em ms. com LATENCY_MEASURED o requisito tambem tem de ser dado em ms: no
+// sky com ContikiMAC a sonda sozinha leva ate ~125 ms por enlace, e com 20 nenhum enlace caberia
+#define LATENCY_STATIC 0
+#define LATENCY_MEASURED 1
+
+#ifndef LATENCY_SOURCE
+#define LATENCY_SOURCE LATENCY_STATIC
+#endif
+
+// motor de descoberta: busca em profundidade com token (original) ou Bellman-Ford distribuido
+#define ENGINE_TOKEN_DFS 0
+#define ENGINE_BELLMAN_FORD 1
+
+#ifndef DISCOVERY_ENGINE
+#define DISCOVERY_ENGINE ENGINE_TOKEN_DFS
+#endif
+
+// Bellman-Ford: espera para agrupar melhorias antes de difundir e silencio que encerra a descoberta
+#define DV_JITTER (CLOCK_SECOND / 4)
+#define DV_QUIET_TIME 3
 #define DEVICE_D 1
+
+// unidades da tabela estatica (ms com LATENCY_MEASURED)
+#ifndef LATENCY_REQUIREMENT
 #define LATENCY_REQUIREMENT 20
+#endif
+
+// espera pelas respostas dos vizinhos a uma consulta ao cache antes de refazer a descoberta
+#define CACHE_QUERY_TIMEOUT (CLOCK_SECOND * 2)
+
+// rota escolhida: piora (em %) da latencia total ou do custo a partir da qual os vertices avisam DEVICE_D; a
+// latencia so e vigiada com LATENCY_MEASURED, a tabela estatica nao muda
+#ifndef REOPT_THRESHOLD
+#define REOPT_THRESHOLD 20
+#endif
+
+// route_history: conjunto associativo de impressoes digitais (HISTORY_SETS x HISTORY_WAYS), FIFO por conjunto
+#ifndef HISTORY_SETS
+#define HISTORY_SETS 16
+#endif
+
+#ifndef HISTORY_WAYS
+#define HISTORY_WAYS 4
+#endif
+
+// busca com token: espera pelo eco dos filhos apos o broadcast, derivada das latencias medidas (ECHO_TIMEOUT_MIN
+// cobre o processamento) e limitada pelo tempo fixo original
+#define ECHO_TIMEOUT_MIN (CLOCK_SECOND / 8)
+#define ECHO_TIMEOUT_MAX (CLOCK_SECOND * 5)
+
+// busca com token: quantos filhos de um mesmo pai exploram ao mesmo tempo (1: um de cada vez, o original)
+#ifndef TOKEN_CONCURRENCY
+#define TOKEN_CONCURRENCY 1
+#endif
+
+// filhos aguardando o token; so vizinhos com latencia conhecida chegam a fila
+#ifndef WAIT_QUEUE_SIZE
+#define WAIT_QUEUE_SIZE LINK_LATENCY_MAX_NEIGHBORS
+#endif
+
+#if FRAME_MAX_SIZE > PACKETBUF_SIZE
+#error "MAXIMUM_HOPS nao cabe num quadro: reduza MAXIMUM_HOPS ou aumente PACKETBUF_CONF_SIZE"
+#endif
 
 enum
 {
@@ -39,51 +116,30 @@ enum
   RETRANSMITING_REQUIREMENT_FOR_CHILDREN,
   RETRANSMITING_REQUIREMENT,
   REQUESTING_REQUIREMENT,
-  SENDING_ANSWER
-};
+  SENDING_ANSWER,
+
+  DISTANCE_VECTOR,
 
-static const int latency_matrix[MAXIMUM_DEVICES][MAXIMUM_DEVICES] = {
-    {0, 6, 2, 74, 35, 86, 66, 96, 16, 77, 21, 52, 41, 45, 82, 31},
-    {6, 0, 3, 60, 53, 70, 86, 54, 38, 59, 63, 28, 10, 96, 95, 97},
-    {2, 3, 0, 30, 8, 36, 57, 69, 65, 46, 1, 62, 94, 9, 27, 26},
-    {74, 60, 30, 0, 31, 58, 37, 77, 72, 78, 52, 29, 50, 56, 47, 24},
-    {35, 53, 8, 31, 0, 82, 31, 64, 76, 100, 93, 50, 27, 1, 15, 25},
-    {86, 70, 36, 58, 82, 0, 40, 75, 97, 22, 94, 30, 10, 75, 65, 38},
-    {66, 86, 57, 37, 31, 40, 0, 32, 95, 30, 18, 64, 39, 87, 20, 46},
-    {96, 54, 69, 77, 64, 75, 32, 0, 44, 35, 27, 6, 51, 64, 41, 65},
-    {16, 38, 65, 72, 76, 97, 95, 44, 0, 57, 58, 37, 48, 49, 34, 46},
-    {77, 59, 46, 78, 100, 22, 30, 35, 57, 0, 2, 80, 35, 91, 59, 99},
-    {21, 63, 1, 52, 93, 94, 18, 27, 58, 2, 0, 66, 98, 15, 1, 3},
-    {52, 28, 62, 29, 50, 30, 64, 6, 37, 80, 66, 0, 12, 63, 8, 97},
-    {41, 10, 94, 50, 27, 10, 39, 51, 48, 35, 98, 12, 0, 50, 61, 54},
-    {45, 96, 9, 56, 1, 75, 87, 64, 49, 91, 15, 63, 50, 0, 23, 39},
-    {82, 95, 27, 47, 15, 65, 20, 41, 34, 59, 1, 8, 61, 23, 0, 51},
-    {31, 97, 26, 24, 25, 38, 46, 65, 46, 99, 3, 97, 54, 39, 51, 0}
+  // mensagens do cache e da rota escolhida por ultimo: valem entre pedidos, as anteriores so no pedido atual
+  CACHE_QUERY,
+  CACHED_ANSWER,
+  CACHE_HIT,
+  CACHE_MISS,
+  CACHE_INVALIDATE,
 
+  ROUTE_SELECTED,
+  LINK_UPDATE,
+  PRICE_UPDATE
 };
 
 // =============================================================================================================
 
 struct route
 {
-  int weight;
-  char way[MAXIMUM_DEVICES], kind[8];
-};
-
-struct broadcast_message
-{
-  double w;
-  char kind[8];
-  int title, latency;
-  char route[MAXIMUM_DEVICES];
-};
-
-struct unicast_message
-{
-  double w;
-  int title, index_vector_route, latency;
-  char route[MAXIMUM_DEVICES], kind[8];
-  struct route *solution;
+  route_cost_t weight;
+  int latency;
+  struct path way;
+  uint8_t kind;
 };
 
 struct vertex
@@ -98,27 +154,61 @@ static struct broadcast_conn broadcast;
 static struct unicast_conn unicast;
 static struct route the_best_route;
 
-static char *kind,
-    int_to_char[4],
-    route_relative[MAXIMUM_DEVICES];
+// alocacoes nao dominadas deste vertice e da sua subarvore; em DEVICE_D, as opcoes finais
+static struct pareto_front front;
+
+static uint8_t kind;
+
+static struct path route_relative;
+
+// busca com token: filhos com o token deste vertice e de quem este vertice recebeu o token
+static int tokens_out;
+static linkaddr_t token_father;
+
+static uint32_t route_history[HISTORY_SETS][HISTORY_WAYS];
+static uint8_t route_history_next[HISTORY_SETS];
+
+static unsigned int history_hits,
+    history_misses,
+    history_evictions,
+    messages_sent;
+
+// Bellman-Ford: menor latencia conhecida a partir de DEVICE_D e o caminho correspondente
+static int dv_latency = -1,
+           dv_pending,
+           answer_pending;
 
-static double w_current;
+static struct path dv_path;
+
+// pedido atual de DEVICE_D (mensagens de pedidos anteriores sao descartadas) e o seu requisito
+static uint8_t current_request = 1;
+static int latency_requirement = LATENCY_REQUIREMENT;
+
+// respostas dos vizinhos a consulta ao cache de DEVICE_D
+static int cache_query_pending,
+    cache_hits,
+    cache_misses;
+
+// rota escolhida por DEVICE_D e a sua latencia total no momento da escolha; drift e o quanto o enlace ate o
+// pai nela mudou desde entao e unsent, a parte disso que DEVICE_D ainda nao conhece
+static struct path selected_route;
+static int selected_latency,
+    route_drift,
+    route_unsent;
+
+static node_id_t vertex_current;
 
 static int number_of_vertices,
-    vertex_current,
     status_token,
     status_eco,
     latency_relative,
     price_vertex,
-    resouce_vertex,
-    index_vector_route;
+    resouce_vertex;
 
 // =============================================================================================================
 
-MEMB(route_memb, struct route, MAXIMUM_DEVICES);
-MEMB(vertex_memb, struct vertex, MAXIMUM_DEVICES);
+MEMB(vertex_memb, struct vertex, WAIT_QUEUE_SIZE);
 
-LIST(route_history);
 LIST(wait_queue);
 
 PROCESS(unicast_process, "Unicast process");
@@ -129,99 +219,181 @@ AUTOSTART_PROCESSES(&broadcast_process, &script_process, &unicast_process);
 
 // =============================================================================================================
 
-void send_unicast(struct unicast_message *message, const linkaddr_t *address);
+void send_unicast(struct discovery_frame *message, const linkaddr_t *address);
+
+// =============================================================================================================
+
+// id de 16 bits a partir do endereco Rime e vice-versa (u8[0] e o byte baixo, como no Cooja)
+
+static node_id_t node_id(const linkaddr_t *address)
+{
+  return address->u8[0] | (node_id_t)address->u8[1] << 8;
+}
+
+static void node_address(node_id_t id, linkaddr_t *address)
+{
+  address->u8[0] = id & 0xff;
+  address->u8[1] = id >> 8;
+}
+
+// =============================================================================================================
+
+route_cost_t calculete_w(int latency_relative)
+{
+  return route_cost(latency_relative, price_vertex, resouce_vertex);
+}
 
 // =============================================================================================================
 
-double calculete_w(int latency_relative)
+#if COST_BENCHMARK
+
+// ciclos por avaliacao do custo em ponto fixo e da referencia em double, medidos com o rtimer
+
+static void benchmark_cost()
 {
 
-  double fLatency = latency_relative / 150;
-  double fPrice = price_vertex / 20;
-  double fResouce = 1 / resouce_vertex;
+  static volatile route_cost_t fixed;
+  static volatile double reference;
+  rtimer_clock_t start, fixed_ticks, reference_ticks;
+  int i;
 
-  double w = pow(fLatency, 0.7f) *
-             pow(fPrice, 0.2f) *
-             pow(fResouce, 0.1f);
+  start = RTIMER_NOW();
+  for (i = 1; i <= COST_BENCHMARK_ROUNDS; i++)
+    fixed = route_cost(i % latency_requirement + 1, price_vertex, resouce_vertex);
+  fixed_ticks = RTIMER_NOW() - start;
 
-  return w;
+  start = RTIMER_NOW();
+  for (i = 1; i <= COST_BENCHMARK_ROUNDS; i++)
+    reference = route_cost_reference(i % latency_requirement + 1, price_vertex, resouce_vertex);
+  reference_ticks = RTIMER_NOW() - start;
+
+  printf("Cost benchmark: fixed %lu cycles, double %lu cycles per call\n",
+         (unsigned long)((uint64_t)fixed_ticks * F_CPU / RTIMER_SECOND / COST_BENCHMARK_ROUNDS),
+         (unsigned long)((uint64_t)reference_ticks * F_CPU / RTIMER_SECOND / COST_BENCHMARK_ROUNDS));
 }
 
+#endif
+
 // =============================================================================================================
 
-static void print_wait_queue()
+#if LATENCY_SOURCE == LATENCY_STATIC
+
+// latencia da tabela estatica (flash) entre dois vertices, ou LINK_LATENCY_UNKNOWN sem enlace
+
+static int latency_table_get(node_id_t a, node_id_t b)
 {
 
-  printf("Queue: ");
+  long row, column;
+  int value;
 
-  struct vertex *n;
+  if (a == b)
+    return 0;
 
-  for (n = list_head(wait_queue); n != NULL; n = list_item_next(n))
-  {
-    linkaddr_t *l = &n->addr;
-    printf("V = %d ", l->u8[0]);
-  }
+  row = (long)(a < b ? a : b) - 1;
+  column = (long)(a < b ? b : a) - 1;
 
-  printf("\n");
+  if (row < 0 || column >= LATENCY_TABLE_NODES)
+    return LINK_LATENCY_UNKNOWN;
+
+  value = latency_table[row * LATENCY_TABLE_NODES - row * (row + 1) / 2 + column - row - 1];
+
+  return value ? value : LINK_LATENCY_UNKNOWN;
 }
 
+#endif
+
 // =============================================================================================================
 
-static int check_vertex_in_route(int c, char route_param[])
+// custo de um salto na descoberta (modelo medido de hop-cost): latencia do enlace pelas sondas ou pela tabela
+// estatica, nunca as duas, pois as unidades diferem; sem amostra da sonda o enlace fica LINK_LATENCY_UNKNOWN
+
+static int link_latency_of(const linkaddr_t *from)
 {
 
-  char *string, route[50];
-  int vertex;
+#if LATENCY_SOURCE == LATENCY_MEASURED
+  return link_latency_get(from);
+#else
+  return latency_table_get(node_id(from), vertex_current);
+#endif
+}
 
-  strcpy(route, route_param);
-  string = strtok(route, "-");
+static const struct hop_cost_model link_cost = {HOP_COST_MEASURED, NULL, 0, 0, 0, link_latency_of};
 
-  while (string != NULL)
-  {
+static int get_link_latency(const linkaddr_t *from)
+{
+  return hop_cost_step(&link_cost, 1, from);
+}
 
-    vertex = atoi(string);
+// 1 se algum vizinho fora de route tem enlace (medido ou da tabela, conforme LATENCY_SOURCE) que cabe em
+// budget: sem nenhum, um broadcast com esse orcamento seria descartado por todos
 
-    if (vertex == c)
+static int neighbor_within_budget(int budget, const struct path *route)
+{
+
+  int latency;
+
+#if LATENCY_SOURCE == LATENCY_MEASURED
+  const linkaddr_t *neighbor;
+  int i;
+
+  for (i = 0; (neighbor = link_latency_neighbor(i, &latency)) != NULL; i++)
+    if (latency <= budget && !path_contains(route, node_id(neighbor)))
       return 1;
+#else
+  static linkaddr_t address;
+  node_id_t id;
+
+  for (id = 1; id <= LATENCY_TABLE_NODES; id++)
+  {
+    if (path_contains(route, id))
+      continue;
+
+    node_address(id, &address);
+    latency = get_link_latency(&address);
 
-    string = strtok(NULL, "-");
+    if (latency != LINK_LATENCY_UNKNOWN && latency <= budget)
+      return 1;
   }
+#endif
 
   return 0;
 }
 
 // =============================================================================================================
 
-static linkaddr_t get_father_of_the_vertex_current(int vertex_current, char route_param[])
+static void print_wait_queue()
 {
 
-  static char *string, route[50];
-  static int father, son;
-  static linkaddr_t address;
-
-  strcpy(route, route_param);
+  printf("Queue: ");
 
-  string = strtok(route, "-");
-  father = atoi(string);
-  string = strtok(NULL, "-");
+  struct vertex *n;
 
-  while (string != NULL)
+  for (n = list_head(wait_queue); n != NULL; n = list_item_next(n))
   {
+    linkaddr_t *l = &n->addr;
+    printf("V = %u ", node_id(l));
+  }
 
-    son = atoi(string);
-    string = strtok(NULL, "-");
+  printf("\n");
+}
 
-    if (son == vertex_current)
-    {
+// =============================================================================================================
 
-      address.u8[0] = father;
-      address.u8[1] = 0;
-    }
-    else
-    {
-      father = son;
-    }
-  }
+static int check_vertex_in_route(int c, const struct path *route)
+{
+  return path_contains(route, c);
+}
+
+// =============================================================================================================
+
+static linkaddr_t get_father_of_the_vertex_current(node_id_t vertex_current, const struct path *route)
+{
+
+  static linkaddr_t address;
+  node_id_t father = path_father(route, vertex_current);
+
+  if (father != 0)
+    node_address(father, &address);
 
   return address;
 }
@@ -256,298 +428,997 @@ static void add_vertex_in_wait_queue(const linkaddr_t *from)
 
 // =============================================================================================================
 
-static void add_route_in_history(char route_param[])
+// entrega o token aos filhos da fila enquanto menos de TOKEN_CONCURRENCY estiverem com ele
+
+static void pass_tokens()
 {
 
-  struct route *route;
-  route = memb_alloc(&route_memb);
+  static struct discovery_frame message;
+  struct vertex *vertex;
 
-  if (route != NULL)
+  while (tokens_out < TOKEN_CONCURRENCY && (vertex = list_pop(wait_queue)) != NULL)
   {
-    strcpy(route->way, route_param);
-    list_add(route_history, route);
+    message.title = PASSING_TOKEN;
+    send_unicast(&message, &vertex->addr);
+
+    memb_free(&vertex_memb, vertex);
+    tokens_out++;
+
+    if (status_token != CLOSED)
+      status_token = WAITING_FOR_ANSWER;
   }
 }
 
 // =============================================================================================================
 
-static int search_route_in_history(char route_param[])
+// FNV-1a sobre os vertices do caminho; 0 fica reservado para posicao vazia
+
+static uint32_t route_fingerprint(const struct path *route)
 {
 
-  struct route *route;
+  uint32_t hash = 2166136261UL;
+  int i;
 
-  for (route = list_head(route_history); route != NULL; route = list_item_next(route))
-    if (!strcmp(route->way, route_param))
-      return 1;
+  for (i = 0; i < route->length; i++)
+  {
+    hash ^= route->hop[i] & 0xff;
+    hash *= 16777619UL;
+    hash ^= route->hop[i] >> 8;
+    hash *= 16777619UL;
+  }
 
-  return 0;
+  return hash ? hash : 1;
 }
 
 // =============================================================================================================
 
-static void start_vertices(char *data)
+static void add_route_in_history(const struct path *route_param)
 {
 
-  vertex_current = linkaddr_node_addr.u8[0];
+  uint32_t fingerprint = route_fingerprint(route_param);
+  int set = fingerprint % HISTORY_SETS,
+      way = route_history_next[set];
 
-  the_best_route.weight = INT_MAX;
-  //the_best_route.w = 99.9f;
-  index_vector_route = 0;
-
-  char *mensagem_serial;
+  if (route_history[set][way] != 0)
+    history_evictions++;
 
-  mensagem_serial = strtok(data, "T");
-  kind = mensagem_serial;
+  route_history[set][way] = fingerprint;
+  route_history_next[set] = (way + 1) % HISTORY_WAYS;
+}
 
-  mensagem_serial = strtok(NULL, "Q");
-  number_of_vertices = atoi(mensagem_serial);
+// =============================================================================================================
 
-  mensagem_serial = strtok(NULL, "C");
-  price_vertex = atoi(mensagem_serial);
+static int search_route_in_history(const struct path *route_param)
+{
 
-  mensagem_serial = strtok(NULL, "R");
-  resouce_vertex = atoi(mensagem_serial);
+  uint32_t fingerprint = route_fingerprint(route_param);
+  int set = fingerprint % HISTORY_SETS,
+      way;
 
-  status_token = (vertex_current == DEVICE_D) ? NO_TOKEN : NOT_STARTED;
+  for (way = 0; way < HISTORY_WAYS; way++)
+  {
+    if (route_history[set][way] == fingerprint)
+    {
+      history_hits++;
+      return 1;
+    }
+  }
 
-  printf("Kind -> %s Price -> %d Resouce -> %d\n", kind, price_vertex, resouce_vertex);
+  history_misses++;
+  return 0;
 }
 
 // =============================================================================================================
 
-static void send_response_to_vertex_father()
+static void clear_solution()
 {
 
-  static linkaddr_t address;
-  static struct unicast_message message;
+  the_best_route.weight = ROUTE_COST_MAX;
+  the_best_route.latency = 0;
+  the_best_route.kind = KIND_UNKNOWN;
+  path_clear(&the_best_route.way);
+
+  pareto_clear(&front);
+}
 
-  address = get_father_of_the_vertex_current(vertex_current, the_best_route.way);
+// =============================================================================================================
+
+// frente guardada no cache vira a solucao atual; a melhor rota e a de menor custo com os expoentes atuais
 
-  message.title = SENDING_ANSWER;
-  message.latency = the_best_route.weight;
-  //message.w       = the_best_route.w;
+static void load_front(const struct pareto_front *cached)
+{
 
-  strcpy(message.kind, the_best_route.kind);
-  strcpy(message.route, the_best_route.way);
+  uint8_t best;
 
-  send_unicast(&message, &address);
+  clear_solution();
+  front = *cached;
+
+  if (pareto_rank(&front, 1, &best) == 0)
+    return;
+
+  the_best_route.weight = placement_cost(&front.entry[best]);
+  the_best_route.latency = front.entry[best].latency;
+  the_best_route.way = front.entry[best].way;
+  the_best_route.kind = front.entry[best].kind;
 }
 
 // =============================================================================================================
 
-static void closing_vertex()
+// estado de descoberta zerado para um pedido novo; em DEVICE_D, tambem dispara o motor
+
+static void reset_discovery(uint8_t request, int requirement)
 {
 
-  status_token = CLOSED;
+  struct vertex *n;
 
-  if (vertex_current != DEVICE_D)
-  {
+  current_request = request;
+  latency_requirement = requirement;
 
-    static linkaddr_t address_father;
-    static struct unicast_message message;
+  clear_solution();
 
-    address_father = get_father_of_the_vertex_current(vertex_current, the_best_route.way);
+  memset(route_history, 0, sizeof(route_history));
+  memset(route_history_next, 0, sizeof(route_history_next));
 
-    message.title = RETURNING_TOKEN;
+  while ((n = list_pop(wait_queue)) != NULL)
+    memb_free(&vertex_memb, n);
 
-    send_unicast(&message, &address_father);
-    send_response_to_vertex_father();
-  }
-  else
+  tokens_out = 0;
+  linkaddr_copy(&token_father, &linkaddr_null);
+
+  path_clear(&selected_route);
+
+  dv_latency = -1;
+  path_clear(&dv_path);
+  dv_pending = 0;
+  answer_pending = 0;
+
+#if DISCOVERY_ENGINE == ENGINE_BELLMAN_FORD
+  status_token = vertex_current ? NO_TOKEN : NOT_STARTED;
+
+  if (vertex_current == DEVICE_D)
   {
-    printf("\n\n\nFinished -> route -> %s; W -> %d; kind -> %s\n\n\n",
-           the_best_route.way, the_best_route.weight, the_best_route.kind);
+    dv_latency = 0;
+    path_append(&dv_path, DEVICE_D);
+    dv_pending = 1;
+    answer_pending = 1;
   }
+
+  process_poll(&broadcast_process);
+#else
+  status_token = (vertex_current == DEVICE_D) ? NO_TOKEN : NOT_STARTED;
+#endif
 }
 
 // =============================================================================================================
 
-void send_unicast(struct unicast_message *message, const linkaddr_t *address)
+static void start_vertices(char *data)
 {
-  packetbuf_clear();
-  packetbuf_copyfrom(message, sizeof(struct unicast_message));
-  unicast_send(&unicast, address);
-}
 
-static void callback_unicast_response(struct unicast_conn *c, const linkaddr_t *from)
-{
+  vertex_current = node_id(&linkaddr_node_addr);
 
-  static struct unicast_message message_in, *message_out;
-  static struct vertex *vertex;
+  char *mensagem_serial;
 
-  status_eco = ECO_ANSWERED;
+  mensagem_serial = strtok(data, "T");
+  kind = kind_parse(mensagem_serial);
 
-  message_out = packetbuf_dataptr();
+  mensagem_serial = strtok(NULL, "Q");
+  number_of_vertices = atoi(mensagem_serial);
 
-  switch (message_out->title)
-  {
+  mensagem_serial = strtok(NULL, "C");
+  price_vertex = atoi(mensagem_serial);
 
-  case SENDING_ANSWER:
+  mensagem_serial = strtok(NULL, "R");
+  resouce_vertex = atoi(mensagem_serial);
 
-    if (message_out->route[0] != '\0')
-    {
+  reset_discovery(current_request, latency_requirement);
 
-      if (message_out->latency < the_best_route.weight)
-      {
+  printf("Kind -> %s Price -> %d Resouce -> %d\n", kind_name(kind), price_vertex, resouce_vertex);
+}
 
-        strcpy(the_best_route.way, message_out->route);
+// =============================================================================================================
 
-        the_best_route.weight = message_out->latency;
+static int offer_placement(int latency, const struct path *way)
+{
 
-        strcpy(the_best_route.kind, message_out->kind);
-      }
+  struct placement placement;
 
-      if (vertex_current != DEVICE_D)
-      {
-        send_response_to_vertex_father();
-      }
-    }
+  placement.latency = latency;
+  placement.price = price_vertex;
+  placement.resource = resouce_vertex;
+  placement.kind = kind;
+  placement.way = *way;
 
-    break;
+  return pareto_insert(&front, &placement);
+}
 
-  case RETURNING_TOKEN:
+// =============================================================================================================
 
-    if (list_length(wait_queue))
-    {
+static void send_placement(int title, const struct placement *placement, const linkaddr_t *address)
+{
 
-      vertex = list_pop(wait_queue);
+  static struct discovery_frame message;
 
-      message_in.title = PASSING_TOKEN;
-      message_in.index_vector_route = index_vector_route;
+  message.title = title;
+  message.latency = placement->latency;
+  message.price = placement->price;
+  message.resource = placement->resource;
 
-      send_unicast(&message_in, &vertex->addr);
-    }
-    else
-      closing_vertex();
+  message.kind = placement->kind;
+  message.route = placement->way;
 
-    break;
+  send_unicast(&message, address);
+}
 
-  case RETRANSMITING_REQUIREMENT_FOR_CHILDREN:
+// =============================================================================================================
 
-    add_vertex_in_wait_queue(from);
-    print_wait_queue();
+// envia a frente inteira, uma alocacao por mensagem, ao pai do vertice em route
 
-    if (status_token != WAITING_FOR_ANSWER)
-    {
+static void send_response_to_vertex_father(const struct path *route)
+{
 
-      vertex = list_pop(wait_queue);
-      status_token = WAITING_FOR_ANSWER;
+  static linkaddr_t address;
+  int i;
 
-      message_in.title = PASSING_TOKEN;
-      send_unicast(&message_in, &vertex->addr);
-    }
+  address = get_father_of_the_vertex_current(vertex_current, route);
 
-    break;
+  for (i = 0; i < front.length; i++)
+    send_placement(SENDING_ANSWER, &front.entry[i], &address);
+}
 
-  case PASSING_TOKEN:
+// =============================================================================================================
 
-    if (status_token != CLOSED)
-    {
-      status_token = NO_TOKEN;
-    }
+static void print_top_placements()
+{
 
-    else
-    {
-      message_in.title = RETURNING_TOKEN;
-      send_unicast(&message_in, from);
-    }
+  static uint8_t index[PARETO_TOP_K];
+  int i, n = pareto_rank(&front, PARETO_TOP_K, index);
 
-    break;
+  for (i = 0; i < n; i++)
+  {
+    struct placement *placement = &front.entry[index[i]];
+
+    printf("Top %d -> route -> ", i + 1);
+    print_path(&placement->way);
+    printf("; W -> %lu/%lu; L -> %u; price -> %u; resource -> %u; kind -> %s\n",
+           (unsigned long)placement_cost(placement), ROUTE_COST_ONE,
+           placement->latency, placement->price, placement->resource, kind_name(placement->kind));
   }
 }
 
 // =============================================================================================================
 
-static void seed_broadcast()
+static void print_solution()
 {
+  printf("\n\n\nFinished -> route -> ");
+  print_path(&the_best_route.way);
+  printf("; W -> %lu/%lu; L -> %d; kind -> %s; messages -> %u\n\n\n",
+         (unsigned long)the_best_route.weight, ROUTE_COST_ONE, the_best_route.latency,
+         kind_name(the_best_route.kind), messages_sent);
 
-  static struct broadcast_message msg;
+  print_top_placements();
+}
 
-  if (vertex_current == DEVICE_D)
-  {
+// =============================================================================================================
 
-    msg.title = REQUESTING_REQUIREMENT;
-    msg.latency = 0;
-    strcat(the_best_route.way, "1-");
-  }
-  else
-  {
+// DEVICE_D avisa os vertices da melhor rota, do primeiro salto ao hospedeiro, que passam a vigia-la
 
-    msg.title = RETRANSMITING_REQUIREMENT;
-    msg.latency = the_best_route.weight;
-  }
+static void select_route()
+{
+
+  static struct discovery_frame message;
+  static linkaddr_t address;
 
-  strcpy(msg.route, the_best_route.way);
-  strcpy(msg.kind, the_best_route.kind);
+  if (the_best_route.way.length < 2 || path_equal(&selected_route, &the_best_route.way))
+    return;
 
-  printf("Seed broadcast with route -> %s\n", msg.route);
+  selected_route = the_best_route.way;
+  selected_latency = the_best_route.latency;
 
-  packetbuf_clear();
-  packetbuf_copyfrom(&msg, sizeof(struct broadcast_message));
-  broadcast_send(&broadcast);
+  message.title = ROUTE_SELECTED;
+  message.latency = selected_latency;
+  message.route = selected_route;
+
+  node_address(selected_route.hop[1], &address);
+  send_unicast(&message, &address);
 }
 
-static void callback_broadcast_response(struct broadcast_conn *c, const linkaddr_t *from)
+static void announce_solution()
 {
+  print_solution();
+  select_route();
+}
 
-  static struct broadcast_message *broadcast_message;
-  static struct unicast_message unicast_message;
+// =============================================================================================================
 
-  broadcast_message = packetbuf_dataptr();
+static void closing_vertex()
+{
 
-  if (check_vertex_in_route(vertex_current, broadcast_message->route))
-    return;
+  status_token = CLOSED;
 
-  printf("Received a broadcast of %d\n", from->u8[0]);
+  printf("History: hits %u misses %u evictions %u\n", history_hits, history_misses, history_evictions);
 
-  if (broadcast_message->title == REQUESTING_REQUIREMENT)
-  {
-    latency_relative = latency_matrix[from->u8[0] - 1][vertex_current - 1];
-  }
-  else if (broadcast_message->title == RETRANSMITING_REQUIREMENT)
+  route_cache_store(latency_requirement, &front, clock_seconds());
+
+  if (vertex_current != DEVICE_D)
   {
-    latency_relative = broadcast_message->latency + latency_matrix[from->u8[0] - 1][vertex_current - 1];
-  }
 
-  strcpy(route_relative, broadcast_message->route);
-  sprintf(int_to_char, "%d", vertex_current);
-  strcat(route_relative, int_to_char);
-  strcat(route_relative, "-");
+    static struct discovery_frame message;
 
-  if (latency_relative > LATENCY_REQUIREMENT)
-  {
-    printf("Route %s rejected! L = %d\n", route_relative, latency_relative);
-    return;
+    // as respostas sobem pelo pai da melhor rota antes de o token voltar a quem o entregou: se o token
+    // chegasse primeiro, DEVICE_D poderia fechar antes de a frente subir pelo seu proprio caminho
+    send_response_to_vertex_father(&the_best_route.way);
+
+    message.title = RETURNING_TOKEN;
+    send_unicast(&message, &token_father);
   }
   else
-  {
-    printf("Route %s is OK! W = %d\n", route_relative, latency_relative);
+    announce_solution();
+}
 
-    double w = calculete_w(latency_relative);
+// =============================================================================================================
+
+void send_unicast(struct discovery_frame *message, const linkaddr_t *address)
+{
+  message->request = current_request;
+
+  packetbuf_clear();
+  packetbuf_set_datalen(frame_encode(message, packetbuf_dataptr()));
+  unicast_send(&unicast, address);
+}
+
+// alocacao recebida (copiada em placement) entra na frente e, se for a de menor custo, vira a melhor rota;
+// 1 se entrou na frente
+
+static int receive_placement(struct discovery_frame *message, struct placement *placement)
+{
+
+  route_cost_t w;
+  int inserted;
+
+  placement->latency = message->latency;
+  placement->price = message->price;
+  placement->resource = message->resource;
+  placement->kind = message->kind;
+  placement->way = message->route;
+
+  inserted = pareto_insert(&front, placement);
+
+  // o peso e recalculado com os expoentes locais, nao os de quem respondeu
+  w = placement_cost(placement);
+
+  if (w < the_best_route.weight)
+  {
+
+    the_best_route.way = message->route;
+
+    the_best_route.weight = w;
+    the_best_route.latency = message->latency;
+
+    the_best_route.kind = message->kind;
+  }
+
+  return inserted;
+}
+
+// =============================================================================================================
+
+// responde a consulta de DEVICE_D com a frente guardada para o requisito (CACHED_ANSWER... CACHE_HIT) ou
+// CACHE_MISS; fica calado se o enlace ate DEVICE_D ja passa do requisito, pois nao esta em nenhuma rota
+
+static void answer_cache_query(const struct discovery_frame *query, const linkaddr_t *from)
+{
+
+  static struct discovery_frame message;
+  const struct pareto_front *cached;
+  int i, link_latency = get_link_latency(from);
+
+  if (vertex_current == 0 || vertex_current == DEVICE_D)
+    return;
+
+  if (link_latency == LINK_LATENCY_UNKNOWN || link_latency > query->requirement)
+    return;
+
+  cached = route_cache_lookup(query->requirement, clock_seconds());
+
+  if (cached != NULL)
+  {
+    for (i = 0; i < cached->length; i++)
+      send_placement(CACHED_ANSWER, &cached->entry[i], from);
+  }
+
+  message.title = cached != NULL ? CACHE_HIT : CACHE_MISS;
+  send_unicast(&message, from);
+}
+
+// =============================================================================================================
+
+// descarta as frentes que usam o enlace a-b e avisa o pai no caminho atingido, ate DEVICE_D
+
+static void invalidate_link(node_id_t a, node_id_t b, const struct path *route)
+{
+
+  static struct discovery_frame message;
+  static struct path affected;
+  static linkaddr_t address;
+  node_id_t father;
+
+  if (route_cache_invalidate_link(a, b, &affected))
+  {
+    printf("Cache invalidated by link %u-%u\n", a, b);
+
+    if (route == NULL)
+      route = &affected;
+  }
+
+  if (route == NULL || (father = path_father(route, vertex_current)) == 0)
+    return;
+
+  message.title = CACHE_INVALIDATE;
+  message.link[0] = a;
+  message.link[1] = b;
+  message.route = *route;
+
+  node_address(father, &address);
+
+  send_unicast(&message, &address);
+}
+
+// =============================================================================================================
+
+// aviso de mudanca na rota escolhida, de vertice em vertice pelo pai em selected_route ate DEVICE_D
+
+static void push_route_update(int title, node_id_t a, node_id_t b, int delta)
+{
+
+  static struct discovery_frame message;
+  static linkaddr_t address;
+  node_id_t father = path_father(&selected_route, vertex_current);
+
+  if (father == 0)
+    return;
+
+  message.title = title;
+  message.link[0] = a;
+  message.link[1] = b;
+  message.latency = (uint16_t)delta;
+  message.price = price_vertex;
+  message.route = selected_route;
+
+  node_address(father, &address);
+  send_unicast(&message, &address);
+}
+
+#if LATENCY_SOURCE == LATENCY_MEASURED
+
+// cada vertice da rota escolhida vigia o enlace ate o seu pai nela; mudancas pequenas ficam locais e so
+// sobem quando a latencia total passa do requisito ou piora mais de REOPT_THRESHOLD %
+
+static void watch_route_link(node_id_t neighbor, int delta)
+{
+
+  int limit = selected_latency + selected_latency * REOPT_THRESHOLD / 100;
+
+  if (selected_route.length == 0 || path_father(&selected_route, vertex_current) != neighbor)
+    return;
+
+  route_drift += delta;
+  route_unsent += delta;
+
+  if (limit > latency_requirement)
+    limit = latency_requirement;
+
+  if (selected_latency + route_drift <= limit || route_unsent == 0)
+    return;
+
+  printf("Route link %u-%u drifted %d, updating\n", neighbor, vertex_current, route_drift);
+
+  push_route_update(LINK_UPDATE, neighbor, vertex_current, route_unsent);
+  route_unsent = 0;
+}
+
+static void link_latency_changed(const linkaddr_t *neighbor, int previous, int latency)
+{
+  invalidate_link(vertex_current, node_id(neighbor), NULL);
+  watch_route_link(node_id(neighbor), latency - previous);
+}
+
+#endif
+
+// o hospedeiro da rota escolhida avisa quando o novo preco encarece a rota mais de REOPT_THRESHOLD %
+
+static void price_changed(int previous)
+{
+
+  uint64_t before, after;
+  int latency = selected_latency + route_drift;
+
+  // as frentes guardadas aqui levam o preco antigo
+  route_cache_flush();
+
+  if (selected_route.length == 0 || selected_route.hop[selected_route.length - 1] != vertex_current)
+    return;
+
+  before = route_cost(latency, previous, resouce_vertex);
+  after = route_cost(latency, price_vertex, resouce_vertex);
+
+  if (after * 100 <= before * (100 + REOPT_THRESHOLD))
+    return;
+
+  printf("Price %d -> %d, updating\n", previous, price_vertex);
+
+  push_route_update(PRICE_UPDATE, vertex_current, vertex_current, 0);
+}
+
+// =============================================================================================================
+
+// DEVICE_D corrige as alocacoes da frente atingidas pelo aviso, descarta as que passam do requisito e refaz a
+// escolha entre as que restam; so refaz a descoberta se nenhuma sobrar
+
+static void reoptimise(const struct discovery_frame *update)
+{
+
+  static struct pareto_front updated;
+  static struct placement placement;
+  int i, delta = (int16_t)update->latency;
+
+  pareto_clear(&updated);
+
+  for (i = 0; i < front.length; i++)
+  {
+    placement = front.entry[i];
+
+    if (update->title == LINK_UPDATE && path_uses_link(&placement.way, update->link[0], update->link[1]))
+      placement.latency += delta;
+
+    if (update->title == PRICE_UPDATE && placement.way.hop[placement.way.length - 1] == update->link[0])
+      placement.price = update->price;
+
+    if (placement.latency <= latency_requirement)
+      pareto_insert(&updated, &placement);
+  }
+
+  if (update->title == LINK_UPDATE && path_uses_link(&selected_route, update->link[0], update->link[1]))
+    selected_latency += delta;
+
+  if (updated.length == 0)
+  {
+    printf("Route lost, discovering\n");
+    reset_discovery(current_request + 1, latency_requirement);
+    return;
+  }
+
+  load_front(&updated);
+  route_cache_store(latency_requirement, &front, clock_seconds());
+
+  if (path_equal(&selected_route, &the_best_route.way))
+  {
+    printf("Route kept -> W -> %lu/%lu; L -> %d\n", (unsigned long)the_best_route.weight, ROUTE_COST_ONE,
+           the_best_route.latency);
+    selected_latency = the_best_route.latency;
+    return;
+  }
+
+  printf("Route switched\n");
+  announce_solution();
+}
+
+// =============================================================================================================
+
+static void callback_unicast_response(struct unicast_conn *c, const linkaddr_t *from)
+{
+
+  static struct discovery_frame message_in, received, *message_out;
+  static struct placement placement;
+  static linkaddr_t address;
+  node_id_t next;
+  int inserted;
+
+  if (!frame_decode(packetbuf_dataptr(), packetbuf_datalen(), &received))
+    return;
+
+  message_out = &received;
+
+  if (message_out->title < CACHE_QUERY)
+  {
+    if (message_out->request != current_request)
+      return;
+
+    status_eco = ECO_ANSWERED;
+  }
+
+  switch (message_out->title)
+  {
+
+  case CACHED_ANSWER:
+
+    if (cache_query_pending && message_out->route.length != 0)
+      receive_placement(message_out, &placement);
+
+    break;
+
+  case CACHE_HIT:
+
+    cache_hits += cache_query_pending;
+    break;
+
+  case CACHE_MISS:
+
+    cache_misses += cache_query_pending;
+    break;
+
+  case CACHE_INVALIDATE:
+
+    invalidate_link(message_out->link[0], message_out->link[1], &message_out->route);
+    break;
+
+  case ROUTE_SELECTED:
+
+    selected_route = message_out->route;
+    selected_latency = message_out->latency;
+    route_drift = route_unsent = 0;
+
+    if ((next = path_child(&selected_route, vertex_current)) != 0)
+    {
+      node_address(next, &address);
+      send_unicast(message_out, &address);
+    }
+
+    break;
+
+  case LINK_UPDATE:
+  case PRICE_UPDATE:
+
+#if LATENCY_SOURCE == LATENCY_STATIC
+    // as rotas estao em unidades da tabela: o delta de sonda (ms) de um vertice com LATENCY_MEASURED nao vale
+    if (message_out->title == LINK_UPDATE)
+      break;
+#endif
+
+    if (vertex_current == DEVICE_D)
+      reoptimise(message_out);
+    else if ((next = path_father(&message_out->route, vertex_current)) != 0)
+    {
+      node_address(next, &address);
+      send_unicast(message_out, &address);
+    }
+
+    break;
+
+  case SENDING_ANSWER:
+
+    if (message_out->route.length != 0)
+    {
+
+      inserted = receive_placement(message_out, &placement);
+
+#if DISCOVERY_ENGINE == ENGINE_TOKEN_DFS
+      // so a alocacao nova sobe: o pai ja recebeu o restante da frente
+      if (vertex_current != DEVICE_D && inserted)
+      {
+        linkaddr_t father = get_father_of_the_vertex_current(vertex_current, &the_best_route.way);
+        send_placement(SENDING_ANSWER, &placement, &father);
+      }
+
+      // resposta que chega a DEVICE_D depois do fechamento: anuncia de novo se a melhor rota mudou
+      else if (vertex_current == DEVICE_D && status_token == CLOSED && !path_equal(&selected_route, &the_best_route.way))
+        announce_solution();
+#else
+      // a resposta sobe pelo pai atual da arvore de menor latencia, nao pelo caminho de quem respondeu
+      if (inserted)
+      {
+        answer_pending = 1;
+        process_poll(&broadcast_process);
+      }
+#endif
+    }
+
+    break;
+
+  case RETURNING_TOKEN:
+
+    if (tokens_out > 0)
+      tokens_out--;
+
+    pass_tokens();
+
+    // fecha quando o ultimo filho devolve o token; ja fechado, as respostas dos atrasados ja subiram
+    if (tokens_out == 0 && status_token == WAITING_FOR_ANSWER)
+      closing_vertex();
+
+    break;
+
+  case RETRANSMITING_REQUIREMENT_FOR_CHILDREN:
+
+    add_vertex_in_wait_queue(from);
+    print_wait_queue();
+
+    pass_tokens();
+
+    break;
+
+  case PASSING_TOKEN:
+
+    // so o primeiro token vale; quem ja explora ou ja fechou devolve os outros na hora, pois a sua
+    // frente sobe pelo pai da melhor rota de qualquer forma
+    if (status_token == NOT_STARTED)
+    {
+      status_token = NO_TOKEN;
+      linkaddr_copy(&token_father, from);
+
+      process_poll(&broadcast_process);
+    }
+    else
+    {
+      message_in.title = RETURNING_TOKEN;
+      send_unicast(&message_in, from);
+    }
+
+    break;
+  }
+}
+
+// =============================================================================================================
+
+static void send_broadcast(struct discovery_frame *msg)
+{
+  msg->request = current_request;
+  msg->requirement = latency_requirement;
+  msg->budget = latency_requirement > msg->latency ? latency_requirement - msg->latency : 0;
+
+  packetbuf_clear();
+  packetbuf_set_datalen(frame_encode(msg, packetbuf_dataptr()));
+  broadcast_send(&broadcast);
+}
+
+// =============================================================================================================
+
+static void seed_broadcast()
+{
+
+  static struct discovery_frame msg;
+
+  if (vertex_current == DEVICE_D)
+  {
+
+    msg.title = REQUESTING_REQUIREMENT;
+    msg.latency = 0;
+
+    path_clear(&the_best_route.way);
+    path_append(&the_best_route.way, DEVICE_D);
+  }
+  else
+  {
+
+    msg.title = RETRANSMITING_REQUIREMENT;
+    msg.latency = the_best_route.latency;
+  }
+
+  msg.route = the_best_route.way;
+  msg.kind = the_best_route.kind;
+
+  printf("Seed broadcast with route -> ");
+  print_path(&msg.route);
+  printf("\n");
+
+  send_broadcast(&msg);
+}
+
+// =============================================================================================================
+
+#if DISCOVERY_ENGINE == ENGINE_BELLMAN_FORD
+
+static void seed_distance_vector()
+{
+
+  static struct discovery_frame msg;
+
+  if (!neighbor_within_budget(latency_requirement - dv_latency, &dv_path))
+  {
+    printf("Distance %d leaves no budget, not flooding\n", dv_latency);
+    return;
+  }
+
+  msg.title = DISTANCE_VECTOR;
+  msg.latency = dv_latency;
+  msg.route = dv_path;
+
+  send_broadcast(&msg);
+}
+
+// =============================================================================================================
+
+// relaxa o enlace from -> vertex_current; descarta caminhos acima de latency_requirement
+
+static void receive_distance_vector(struct discovery_frame *message, const linkaddr_t *from)
+{
+
+  struct path candidate;
+  int latency, link_latency;
+  route_cost_t w;
+
+  if (vertex_current == DEVICE_D || check_vertex_in_route(vertex_current, &message->route))
+    return;
+
+  link_latency = get_link_latency(from);
+
+  if (link_latency == LINK_LATENCY_UNKNOWN || link_latency > message->budget)
+    return;
+
+  latency = hop_cost_next(&link_cost, message->latency, message->route.length, from);
+
+  if (latency == HOP_COST_UNKNOWN || latency > latency_requirement || (dv_latency >= 0 && latency >= dv_latency))
+    return;
+
+  candidate = message->route;
+
+  if (!path_append(&candidate, vertex_current))
+    return;
+
+  dv_latency = latency;
+  dv_path = candidate;
+  dv_pending = 1;
+
+  w = calculete_w(latency);
+
+  if (w < the_best_route.weight)
+  {
+    the_best_route.weight = w;
+    the_best_route.latency = latency;
+    the_best_route.way = candidate;
+    the_best_route.kind = kind;
+  }
+
+  if (offer_placement(latency, &candidate))
+    answer_pending = 1;
+
+  printf("Distance %d via %u\n", dv_latency, node_id(from));
+
+  process_poll(&broadcast_process);
+}
+
+#endif
+
+// =============================================================================================================
+
+static void callback_broadcast_response(struct broadcast_conn *c, const linkaddr_t *from)
+{
+
+  static struct discovery_frame received, *broadcast_message;
+  static struct discovery_frame unicast_message;
+  int link_latency;
+
+  if (!frame_decode(packetbuf_dataptr(), packetbuf_datalen(), &received))
+    return;
+
+  broadcast_message = &received;
+
+  if (broadcast_message->title == CACHE_QUERY)
+  {
+    answer_cache_query(broadcast_message, from);
+    return;
+  }
+
+  // pedido novo de DEVICE_D recomeca a descoberta; pedidos anteriores sao ignorados
+  if (broadcast_message->request != current_request)
+  {
+    if ((int8_t)(broadcast_message->request - current_request) < 0)
+      return;
+
+    reset_discovery(broadcast_message->request, broadcast_message->requirement);
+  }
+
+#if DISCOVERY_ENGINE == ENGINE_BELLMAN_FORD
+  if (broadcast_message->title == DISTANCE_VECTOR && status_token != NOT_STARTED)
+    receive_distance_vector(broadcast_message, from);
+
+  return;
+#endif
+
+  if (check_vertex_in_route(vertex_current, &broadcast_message->route))
+    return;
+
+  printf("Received a broadcast of %u\n", node_id(from));
+
+  link_latency = get_link_latency(from);
+
+  if (link_latency == LINK_LATENCY_UNKNOWN)
+  {
+    printf("No latency for link %u -> %u\n", node_id(from), vertex_current);
+    return;
+  }
+
+  // o enlace ja nao cabe no que resta do requisito: descarta antes de montar o caminho
+  if (link_latency > broadcast_message->budget)
+    return;
+
+  // DEVICE_D difunde latencia 0: o primeiro salto soma so o enlace
+  latency_relative = hop_cost_next(&link_cost, broadcast_message->latency, broadcast_message->route.length, from);
+
+  if (latency_relative == HOP_COST_UNKNOWN)
+    return;
+
+  route_relative = broadcast_message->route;
+
+  if (!path_append(&route_relative, vertex_current))
+  {
+    printf("Route too long, %d hops\n", route_relative.length);
+    return;
+  }
+
+  if (latency_relative > latency_requirement)
+  {
+    printf("Route ");
+    print_path(&route_relative);
+    printf(" rejected! L = %d\n", latency_relative);
+    return;
+  }
+  else
+  {
+    printf("Route ");
+    print_path(&route_relative);
+    printf(" is OK! W = %d\n", latency_relative);
+
+    route_cost_t w = calculete_w(latency_relative);
 
     if (the_best_route.weight > w)
     {
 
       the_best_route.weight = w;
+      the_best_route.latency = latency_relative;
 
-      strcpy(the_best_route.kind, kind);
-      strcpy(the_best_route.way, route_relative);
+      the_best_route.kind = kind;
+      the_best_route.way = route_relative;
     }
 
+    offer_placement(latency_relative, &route_relative);
+
     unicast_message.title = RETRANSMITING_REQUIREMENT_FOR_CHILDREN;
 
-    if (search_route_in_history(route_relative))
+    if (search_route_in_history(&route_relative))
       return;
 
-    add_route_in_history(route_relative);
+    add_route_in_history(&route_relative);
     send_unicast(&unicast_message, from);
   }
 }
 
 // =============================================================================================================
 
-static const struct broadcast_callbacks broadcast_call = {callback_broadcast_response};
-static const struct unicast_callbacks unicast_callbacks = {callback_unicast_response};
+static void callback_broadcast_sent(struct broadcast_conn *c, int status, int num_tx)
+{
+  messages_sent++;
+}
+
+static void callback_unicast_sent(struct unicast_conn *c, int status, int num_tx)
+{
+  messages_sent++;
+}
+
+static const struct broadcast_callbacks broadcast_call = {callback_broadcast_response, callback_broadcast_sent};
+static const struct unicast_callbacks unicast_callbacks = {callback_unicast_response, callback_unicast_sent};
+
+// =============================================================================================================
+
+// so os vizinhos cujo enlace cabe no que resta do requisito podem aceitar a rota: espera o maior RTO entre eles;
+// sem vizinho medido (ou com LATENCY_STATIC), o tempo fixo
+
+static clock_time_t echo_timeout()
+{
+
+  clock_time_t timeout;
+  int rto = LINK_LATENCY_UNKNOWN;
+
+#if LATENCY_SOURCE == LATENCY_MEASURED
+  rto = link_latency_echo_timeout(latency_requirement - the_best_route.latency);
+#endif
+
+  if (rto == LINK_LATENCY_UNKNOWN)
+    return ECHO_TIMEOUT_MAX;
+
+  timeout = ECHO_TIMEOUT_MIN + (clock_time_t)rto * CLOCK_SECOND / 1000;
+
+  return timeout < ECHO_TIMEOUT_MAX ? timeout : ECHO_TIMEOUT_MAX;
+}
 
 // =============================================================================================================
 
@@ -560,20 +1431,74 @@ PROCESS_THREAD(broadcast_process, ev, data)
 
   static struct etimer et, timer;
 
+#if DISCOVERY_ENGINE == ENGINE_BELLMAN_FORD
+
+  // todos os ramos avancam em paralelo: cada melhoria e difundida e as respostas sobem apos o silencio
+  PROCESS_WAIT_EVENT_UNTIL(status_token != NOT_STARTED);
+
+  while (1)
+  {
+
+    if (dv_pending)
+    {
+      etimer_set(&et, DV_JITTER + random_rand() % DV_JITTER);
+      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+      dv_pending = 0;
+      seed_distance_vector();
+    }
+
+    etimer_set(&timer, CLOCK_SECOND * DV_QUIET_TIME);
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL || etimer_expired(&timer));
+
+    if (ev == PROCESS_EVENT_POLL)
+      continue;
+
+    if (answer_pending)
+    {
+      answer_pending = 0;
+
+      if (vertex_current == DEVICE_D)
+        closing_vertex();
+      else
+      {
+        route_cache_store(latency_requirement, &front, clock_seconds());
+        send_response_to_vertex_father(&dv_path);
+      }
+    }
+  }
+
+#endif
+
   while (1)
   {
 
     etimer_set(&et, CLOCK_SECOND * 8 + random_rand() % (CLOCK_SECOND * 8));
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL || etimer_expired(&et));
 
     if (status_token == NO_TOKEN)
     {
 
+      // nenhum enlace cabe no que resta do requisito: fecha sem difundir
+      if (!neighbor_within_budget(latency_requirement - the_best_route.latency, &the_best_route.way))
+      {
+        printf("No link fits the budget, closing\n");
+        closing_vertex();
+        continue;
+      }
+
+      // token recebido agora: um atraso curto separa os broadcasts de irmaos que o receberam juntos
+      if (ev == PROCESS_EVENT_POLL)
+      {
+        etimer_set(&et, random_rand() % ECHO_TIMEOUT_MIN + 1);
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+      }
+
       seed_broadcast();
 
       status_eco = ECO_SENT;
 
-      etimer_set(&timer, CLOCK_SECOND * 5);
+      etimer_set(&timer, echo_timeout());
       PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
 
       if (status_eco == ECO_SENT)
@@ -595,6 +1520,104 @@ PROCESS_THREAD(script_process, ev, data)
   PROCESS_YIELD_UNTIL(ev == serial_line_event_message);
   start_vertices((char *)data);
 
+#if COST_BENCHMARK
+  benchmark_cost();
+#endif
+
+  // "S" imprime o numero de mensagens enviadas por este vertice (benchmark.js)
+  while (1)
+  {
+    PROCESS_YIELD_UNTIL(ev == serial_line_event_message);
+
+    if (((char *)data)[0] == 'S')
+      printf("Messages -> %u\n", messages_sent);
+
+    // "P<preco>": novo preco deste vertice
+    if (((char *)data)[0] == 'P')
+    {
+      int previous = price_vertex;
+
+      price_vertex = atoi((char *)data + 1);
+      price_changed(previous);
+    }
+
+    // "R<latencia>" em DEVICE_D: novo pedido, servido pelo cache local, pelo cache dos vizinhos (uma ida e
+    // volta) ou por uma descoberta completa
+    if (((char *)data)[0] == 'R' && vertex_current == DEVICE_D)
+    {
+      static struct discovery_frame query;
+      static struct etimer et;
+      const struct pareto_front *cached;
+      int requirement = atoi((char *)data + 1);
+
+      if (requirement <= 0)
+        requirement = LATENCY_REQUIREMENT;
+
+      // locais nao sobrevivem a espera abaixo: dali em diante vale latency_requirement
+      latency_requirement = requirement;
+      cached = route_cache_lookup(requirement, clock_seconds());
+
+      if (cached != NULL)
+      {
+        load_front(cached);
+
+        printf("Cache hit (local)\n");
+        announce_solution();
+        continue;
+      }
+
+      clear_solution();
+      cache_hits = cache_misses = 0;
+      cache_query_pending = 1;
+
+      query.title = CACHE_QUERY;
+      send_broadcast(&query);
+
+      etimer_set(&et, CACHE_QUERY_TIMEOUT);
+
+      // a espera consome os eventos do processo: uma linha serial que chega agora nao e atendida
+      while (!etimer_expired(&et))
+      {
+        PROCESS_WAIT_EVENT();
+
+        if (ev == serial_line_event_message)
+          printf("Cache query pending, ignored \"%s\"\n", (char *)data);
+      }
+
+      cache_query_pending = 0;
+
+      // basta um vizinho sem a frente para que a uniao das subarvores possa estar incompleta
+      if (cache_hits > 0 && cache_misses == 0)
+      {
+        printf("Cache hit (%d neighbors)\n", cache_hits);
+        route_cache_store(latency_requirement, &front, clock_seconds());
+        announce_solution();
+      }
+      else
+      {
+        printf("Cache miss (%d of %d neighbors), discovering\n", cache_misses, cache_hits + cache_misses);
+        reset_discovery(current_request + 1, latency_requirement);
+      }
+
+      // data agora e o etimer, nao uma linha serial
+      continue;
+    }
+
+    // "W<latencia>,<preco>,<recurso>" em milesimos: reordena a frente ja descoberta com novos expoentes
+    if (((char *)data)[0] == 'W')
+    {
+      struct route_cost_exponents exponents;
+      char *field = (char *)data + 1;
+
+      exponents.latency = strtol(field, &field, 10) * 4096 / 1000;
+      exponents.price = strtol(field + (*field == ','), &field, 10) * 4096 / 1000;
+      exponents.resource = strtol(field + (*field == ','), &field, 10) * 4096 / 1000;
+
+      route_cost_set_exponents(&exponents);
+      print_top_placements();
+    }
+  }
+
   PROCESS_END();
 }
 
@@ -607,6 +1630,12 @@ PROCESS_THREAD(unicast_process, ev, data)
   PROCESS_BEGIN();
   unicast_open(&unicast, 146, &unicast_callbacks);
 
+  // com a tabela estatica as sondas nao entram em nenhuma rota: os seus deltas em ms nao podem mexer nelas
+#if LATENCY_SOURCE == LATENCY_MEASURED
+  link_latency_open(130, 147);
+  link_latency_set_listener(link_latency_changed);
+#endif
+
   static struct etimer et;
 
   while (1)
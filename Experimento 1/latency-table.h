@@ -0,0 +1,20 @@
+// gerado por latency-table.py a partir de topology.csv; nao editar
+
+#ifndef LATENCY_TABLE_H
+#define LATENCY_TABLE_H
+
+#include <stdint.h>
+
+#define LATENCY_TABLE_NODES 16
+
+// triangulo superior, linha a linha: enlace (i, j) com i < j (base 0)
+static const uint8_t latency_table[120] = {
+    6, 2, 74, 35, 86, 66, 96, 16, 77, 21, 52, 41, 45, 82, 31, 3, 60, 53, 70, 86,
+    54, 38, 59, 63, 28, 10, 96, 95, 97, 30, 8, 36, 57, 69, 65, 46, 1, 62, 94, 9,
+    27, 26, 31, 58, 37, 77, 72, 78, 52, 29, 50, 56, 47, 24, 82, 31, 64, 76, 100, 93,
+    50, 27, 1, 15, 25, 40, 75, 97, 22, 94, 30, 10, 75, 65, 38, 32, 95, 30, 18, 64,
+    39, 87, 20, 46, 44, 35, 27, 6, 51, 64, 41, 65, 57, 58, 37, 48, 49, 34, 46, 2,
+    80, 35, 91, 59, 99, 66, 98, 15, 1, 3, 12, 63, 8, 97, 50, 61, 54, 23, 39, 51,
+};
+
+#endif
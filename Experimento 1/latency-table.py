@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+# =============================================================================================================
+# gera latency-table.h a partir de uma matriz de latencias em CSV (linha i, coluna j = enlace i+1 -> j+1)
+#
+# uso: latency-table.py topology.csv > latency-table.h
+#
+# a matriz e simetrica, entao so o triangulo superior (i < j) e gravado, um uint8_t por enlace;
+# celulas vazias ou 0 fora da diagonal significam enlace inexistente
+# =============================================================================================================
+
+import csv
+import sys
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit("uso: latency-table.py topology.csv > latency-table.h")
+
+    with open(sys.argv[1], newline="") as f:
+        rows = [[cell.strip() for cell in row] for row in csv.reader(f) if row]
+
+    nodes = len(rows)
+    table = []
+
+    for i in range(nodes):
+        for j in range(i + 1, nodes):
+            cell = rows[i][j] if j < len(rows[i]) else ""
+            value = int(cell) if cell else 0
+
+            if not 0 <= value <= 255:
+                sys.exit("latencia %d -> %d fora de 0..255: %d" % (i + 1, j + 1, value))
+
+            mirror = rows[j][i] if i < len(rows[j]) else ""
+            if mirror and int(mirror) != value:
+                sys.stderr.write("aviso: %d -> %d assimetrico, usando %d\n" % (i + 1, j + 1, value))
+
+            table.append(value)
+
+    out = sys.stdout
+    out.write("// gerado por latency-table.py a partir de %s; nao editar\n\n" % sys.argv[1])
+    out.write("#ifndef LATENCY_TABLE_H\n#define LATENCY_TABLE_H\n\n#include <stdint.h>\n\n")
+    out.write("#define LATENCY_TABLE_NODES %d\n\n" % nodes)
+    out.write("// triangulo superior, linha a linha: enlace (i, j) com i < j (base 0)\n")
+    out.write("static const uint8_t latency_table[%d] = {" % max(len(table), 1))
+
+    for k, value in enumerate(table or [0]):
+        out.write(("\n    " if k % 20 == 0 else " ") + "%d," % value)
+
+    out.write("\n};\n\n#endif\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,243 @@
+#include "link-latency.h"
+
+#include "lib/list.h"
+#include "lib/memb.h"
+#include "lib/random.h"
+#include "net/rime/rime.h"
+#include "net/packetbuf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// =============================================================================================================
+
+enum
+{
+  PROBE,
+  PROBE_ECHO
+};
+
+struct probe_message
+{
+  uint8_t title;
+  rtimer_clock_t timestamp;
+};
+
+struct link
+{
+  struct link *next;
+  linkaddr_t addr;
+  uint16_t latency; // ms << LINK_LATENCY_EWMA_SHIFT
+  uint16_t variance; // desvio medio, ms << 2
+  uint16_t reported; // ms, valor do ultimo aviso
+};
+
+// =============================================================================================================
+
+static struct broadcast_conn probe_broadcast;
+static struct unicast_conn probe_unicast;
+
+static uint16_t broadcast_channel, unicast_channel;
+
+static void (*listener)(const linkaddr_t *neighbor, int previous, int latency);
+
+MEMB(link_memb, struct link, LINK_LATENCY_MAX_NEIGHBORS);
+LIST(links);
+
+PROCESS(link_latency_process, "Link latency process");
+
+// =============================================================================================================
+
+static struct link *find_link(const linkaddr_t *neighbor)
+{
+
+  struct link *l;
+
+  for (l = list_head(links); l != NULL; l = list_item_next(l))
+    if (linkaddr_cmp(&l->addr, neighbor))
+      break;
+
+  return l;
+}
+
+// =============================================================================================================
+
+int link_latency_get(const linkaddr_t *neighbor)
+{
+
+  struct link *l = find_link(neighbor);
+
+  if (l == NULL)
+    return LINK_LATENCY_UNKNOWN;
+
+  return l->latency >> LINK_LATENCY_EWMA_SHIFT;
+}
+
+// =============================================================================================================
+
+const linkaddr_t *link_latency_neighbor(int i, int *latency)
+{
+
+  struct link *l;
+
+  for (l = list_head(links); l != NULL && i > 0; l = list_item_next(l))
+    i--;
+
+  if (l == NULL)
+    return NULL;
+
+  *latency = l->latency >> LINK_LATENCY_EWMA_SHIFT;
+  return &l->addr;
+}
+
+// =============================================================================================================
+
+int link_latency_echo_timeout(int budget)
+{
+
+  struct link *l;
+  int timeout = 0, rto;
+
+  if (list_head(links) == NULL)
+    return LINK_LATENCY_UNKNOWN;
+
+  for (l = list_head(links); l != NULL; l = list_item_next(l))
+  {
+    if ((l->latency >> LINK_LATENCY_EWMA_SHIFT) > budget)
+      continue;
+
+    // variance ja vale 4 x desvio
+    rto = 2 * ((l->latency >> LINK_LATENCY_EWMA_SHIFT) + l->variance);
+
+    if (rto > timeout)
+      timeout = rto;
+  }
+
+  return timeout;
+}
+
+// =============================================================================================================
+
+static void add_sample(const linkaddr_t *neighbor, uint16_t sample)
+{
+
+  struct link *l = find_link(neighbor);
+  int current, previous;
+
+  if (l == NULL)
+  {
+
+    l = memb_alloc(&link_memb);
+
+    if (l == NULL)
+      return;
+
+    linkaddr_copy(&l->addr, neighbor);
+    l->latency = sample << LINK_LATENCY_EWMA_SHIFT;
+    l->variance = sample * 2; // desvio inicial de metade da amostra
+    l->reported = sample;
+    list_add(links, l);
+    return;
+  }
+
+  // desvio += |sample - latency| - desvio / 4, com a media anterior a amostra
+  l->variance += abs(sample - (l->latency >> LINK_LATENCY_EWMA_SHIFT)) - (l->variance >> 2);
+
+  // latency += sample - latency / 2^k, mantido com k bits fracionarios
+  l->latency += sample - (l->latency >> LINK_LATENCY_EWMA_SHIFT);
+
+  current = l->latency >> LINK_LATENCY_EWMA_SHIFT;
+
+  if (abs(current - l->reported) >= LINK_LATENCY_CHANGE_THRESHOLD)
+  {
+    previous = l->reported;
+    l->reported = current;
+
+    if (listener != NULL)
+      listener(neighbor, previous, current);
+  }
+}
+
+// =============================================================================================================
+
+void link_latency_set_listener(void (*changed)(const linkaddr_t *neighbor, int previous, int latency))
+{
+  listener = changed;
+}
+
+// =============================================================================================================
+
+static void probe_received(struct broadcast_conn *c, const linkaddr_t *from)
+{
+
+  struct probe_message *probe = packetbuf_dataptr();
+
+  if (probe->title != PROBE)
+    return;
+
+  probe->title = PROBE_ECHO;
+  packetbuf_copyfrom(probe, sizeof(struct probe_message));
+  unicast_send(&probe_unicast, from);
+}
+
+// =============================================================================================================
+
+static void echo_received(struct unicast_conn *c, const linkaddr_t *from)
+{
+
+  struct probe_message *echo = packetbuf_dataptr();
+  rtimer_clock_t rtt;
+
+  if (echo->title != PROBE_ECHO)
+    return;
+
+  rtt = RTIMER_NOW() - echo->timestamp;
+
+  // metade do tempo de ida e volta, em ms
+  add_sample(from, (uint16_t)(((uint32_t)rtt * 1000) / RTIMER_SECOND / 2));
+}
+
+// =============================================================================================================
+
+static const struct broadcast_callbacks probe_broadcast_call = {probe_received};
+static const struct unicast_callbacks probe_unicast_call = {echo_received};
+
+// =============================================================================================================
+
+void link_latency_open(uint16_t broadcast, uint16_t unicast)
+{
+  broadcast_channel = broadcast;
+  unicast_channel = unicast;
+
+  process_start(&link_latency_process, NULL);
+}
+
+// =============================================================================================================
+
+PROCESS_THREAD(link_latency_process, ev, data)
+{
+
+  static struct etimer et;
+  static struct probe_message probe;
+
+  PROCESS_EXITHANDLER(broadcast_close(&probe_broadcast); unicast_close(&probe_unicast);)
+  PROCESS_BEGIN();
+
+  broadcast_open(&probe_broadcast, broadcast_channel, &probe_broadcast_call);
+  unicast_open(&probe_unicast, unicast_channel, &probe_unicast_call);
+
+  while (1)
+  {
+
+    etimer_set(&et, CLOCK_SECOND * LINK_LATENCY_PROBE_INTERVAL + random_rand() % (CLOCK_SECOND * LINK_LATENCY_PROBE_INTERVAL));
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+    probe.title = PROBE;
+    probe.timestamp = RTIMER_NOW();
+
+    packetbuf_copyfrom(&probe, sizeof(struct probe_message));
+    broadcast_send(&probe_broadcast);
+  }
+
+  PROCESS_END();
+}
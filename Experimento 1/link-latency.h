@@ -0,0 +1,44 @@
+#ifndef LINK_LATENCY_H
+#define LINK_LATENCY_H
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+
+// =============================================================================================================
+// latencia medida por vizinho: sondas em broadcast com marca de tempo, eco em unicast e media movel (EWMA),
+// com o desvio medio ao lado, como o SRTT/RTTVAR do TCP
+// =============================================================================================================
+
+#ifndef LINK_LATENCY_MAX_NEIGHBORS
+#define LINK_LATENCY_MAX_NEIGHBORS 16
+#endif
+#define LINK_LATENCY_PROBE_INTERVAL 10 // segundos (mais um atraso aleatorio de ate o mesmo valor)
+
+// peso de cada amostra nova na media: 1 / 2^LINK_LATENCY_EWMA_SHIFT; no desvio, 1 / 4
+#define LINK_LATENCY_EWMA_SHIFT 3
+
+#define LINK_LATENCY_UNKNOWN -1
+
+// variacao (ms) da media, desde o ultimo aviso, que dispara o aviso de enlace alterado
+#define LINK_LATENCY_CHANGE_THRESHOLD 2
+
+void link_latency_open(uint16_t broadcast_channel, uint16_t unicast_channel);
+
+// latencia suavizada ate o vizinho em ms (metade da ida e volta da sonda), ou LINK_LATENCY_UNKNOWN sem
+// amostras; nao e a unidade da tabela estatica do firmware
+int link_latency_get(const linkaddr_t *neighbor);
+
+// maior tempo de ida e volta esperado (ms, 2 x (media + 4 x desvio), o RTO do TCP) entre os vizinhos cuja
+// latencia cabe em budget; 0 se nenhum cabe, LINK_LATENCY_UNKNOWN sem vizinhos medidos
+int link_latency_echo_timeout(int budget);
+
+// i-esimo vizinho medido (a partir de 0), com a latencia suavizada em latency; NULL depois do ultimo
+const linkaddr_t *link_latency_neighbor(int i, int *latency);
+
+// chamado quando a latencia suavizada de um enlace ja conhecido muda LINK_LATENCY_CHANGE_THRESHOLD ou mais;
+// previous e o valor do aviso anterior
+void link_latency_set_listener(void (*changed)(const linkaddr_t *neighbor, int previous, int latency));
+
+PROCESS_NAME(link_latency_process);
+
+#endif
@@ -0,0 +1,126 @@
+#include "pareto.h"
+
+#include <string.h>
+
+// =============================================================================================================
+
+void pareto_clear(struct pareto_front *front)
+{
+  front->length = 0;
+}
+
+// =============================================================================================================
+
+route_cost_t placement_cost(const struct placement *placement)
+{
+  return route_cost(placement->latency, placement->price, placement->resource);
+}
+
+// =============================================================================================================
+
+// a domina b: nao e pior em nenhum objetivo (iguais tambem contam, para descartar repetidas)
+
+static int dominates(const struct placement *a, const struct placement *b)
+{
+  return a->latency <= b->latency && a->price <= b->price && a->resource >= b->resource;
+}
+
+// =============================================================================================================
+
+int pareto_insert(struct pareto_front *front, const struct placement *placement)
+{
+
+  int i, worst;
+  route_cost_t cost, worst_cost;
+
+  for (i = 0; i < front->length; i++)
+    if (dominates(&front->entry[i], placement))
+      return 0;
+
+  // remove as alocacoes dominadas pela nova
+  for (i = 0; i < front->length;)
+  {
+    if (dominates(placement, &front->entry[i]))
+      front->entry[i] = front->entry[--front->length];
+    else
+      i++;
+  }
+
+  if (front->length < PARETO_MAX)
+  {
+    front->entry[front->length++] = *placement;
+    return 1;
+  }
+
+  worst = 0;
+  worst_cost = placement_cost(&front->entry[0]);
+
+  for (i = 1; i < front->length; i++)
+  {
+    cost = placement_cost(&front->entry[i]);
+
+    if (cost > worst_cost)
+    {
+      worst = i;
+      worst_cost = cost;
+    }
+  }
+
+  if (placement_cost(placement) >= worst_cost)
+    return 0;
+
+  front->entry[worst] = *placement;
+  return 1;
+}
+
+// =============================================================================================================
+
+int pareto_rank(const struct pareto_front *front, int k, uint8_t index[])
+{
+
+  route_cost_t cost[PARETO_MAX];
+  int i, j, n = 0;
+
+  for (i = 0; i < front->length; i++)
+    cost[i] = placement_cost(&front->entry[i]);
+
+  // insercao ordenada das k menores
+  for (i = 0; i < front->length; i++)
+  {
+
+    for (j = n; j > 0 && cost[index[j - 1]] > cost[i]; j--)
+      if (j < k)
+        index[j] = index[j - 1];
+
+    if (j < k)
+    {
+      index[j] = i;
+
+      if (n < k)
+        n++;
+    }
+  }
+
+  return n;
+}
+
+// =============================================================================================================
+
+static const char *const kind_names[] = {"?", "D", "mist", "fog", "cloud"};
+
+uint8_t kind_parse(const char *name)
+{
+
+  uint8_t kind;
+
+  for (kind = KIND_D; kind <= KIND_CLOUD; kind++)
+    if (strcmp(name, kind_names[kind]) == 0)
+      return kind;
+
+  return KIND_UNKNOWN;
+}
+
+const char *kind_name(uint8_t kind)
+{
+  return kind <= KIND_CLOUD ? kind_names[kind] : kind_names[KIND_UNKNOWN];
+}
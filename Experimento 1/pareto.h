@@ -0,0 +1,54 @@
+#ifndef PARETO_H
+#define PARETO_H
+
+#include "route-path.h"
+#include "route-cost.h"
+
+// =============================================================================================================
+// frente de Pareto limitada de alocacoes: menor latencia, menor preco e maior recurso
+// =============================================================================================================
+
+#ifndef PARETO_MAX
+#define PARETO_MAX 4
+#endif
+#define PARETO_TOP_K 3
+
+// tipo do vertice, vindo do serial como "D", "mist", "fog" ou "cloud"
+enum
+{
+  KIND_UNKNOWN,
+  KIND_D,
+  KIND_MIST,
+  KIND_FOG,
+  KIND_CLOUD
+};
+
+struct placement
+{
+  uint16_t latency, price;
+  uint8_t resource, kind;
+  struct path way;
+};
+
+struct pareto_front
+{
+  uint8_t length;
+  struct placement entry[PARETO_MAX];
+};
+
+void pareto_clear(struct pareto_front *front);
+
+// 1 se a alocacao entrou na frente (remove as que ela domina); 0 se dominada, repetida ou pior que
+// todas com a frente cheia. Cheia, sai a de maior route_cost com os expoentes atuais
+int pareto_insert(struct pareto_front *front, const struct placement *placement);
+
+// indices das ate k melhores alocacoes por route_cost; retorna quantas foram escritas
+int pareto_rank(const struct pareto_front *front, int k, uint8_t index[]);
+
+route_cost_t placement_cost(const struct placement *placement);
+
+uint8_t kind_parse(const char *name);
+
+const char *kind_name(uint8_t kind);
+
+#endif
@@ -0,0 +1,99 @@
+#include "route-cache.h"
+
+#include <string.h>
+
+// =============================================================================================================
+
+static struct route_cache_entry cache[ROUTE_CACHE_SIZE];
+
+// =============================================================================================================
+
+static struct route_cache_entry *find_entry(uint16_t requirement)
+{
+
+  int i;
+
+  for (i = 0; i < ROUTE_CACHE_SIZE; i++)
+    if (cache[i].expires != 0 && cache[i].requirement == requirement)
+      return &cache[i];
+
+  return NULL;
+}
+
+// =============================================================================================================
+
+void route_cache_store(uint16_t requirement, const struct pareto_front *front, unsigned long now)
+{
+
+  struct route_cache_entry *entry = find_entry(requirement);
+  int i;
+
+  if (entry == NULL)
+  {
+    entry = &cache[0];
+
+    for (i = 1; i < ROUTE_CACHE_SIZE; i++)
+      if (cache[i].expires < entry->expires)
+        entry = &cache[i];
+  }
+
+  entry->requirement = requirement;
+  entry->expires = now + ROUTE_CACHE_TTL;
+  entry->front = *front;
+}
+
+// =============================================================================================================
+
+const struct pareto_front *route_cache_lookup(uint16_t requirement, unsigned long now)
+{
+
+  struct route_cache_entry *entry = find_entry(requirement);
+
+  if (entry == NULL)
+    return NULL;
+
+  if (now >= entry->expires)
+  {
+    entry->expires = 0;
+    return NULL;
+  }
+
+  return &entry->front;
+}
+
+// =============================================================================================================
+
+int route_cache_invalidate_link(node_id_t a, node_id_t b, struct path *affected)
+{
+
+  int i, j, removed = 0;
+
+  for (i = 0; i < ROUTE_CACHE_SIZE; i++)
+  {
+
+    if (cache[i].expires == 0)
+      continue;
+
+    for (j = 0; j < cache[i].front.length; j++)
+    {
+      if (path_uses_link(&cache[i].front.entry[j].way, a, b))
+      {
+        if (affected != NULL && removed == 0)
+          *affected = cache[i].front.entry[j].way;
+
+        cache[i].expires = 0;
+        removed++;
+        break;
+      }
+    }
+  }
+
+  return removed;
+}
+
+// =============================================================================================================
+
+void route_cache_flush(void)
+{
+  memset(cache, 0, sizeof(cache));
+}
@@ -0,0 +1,35 @@
+#ifndef ROUTE_CACHE_H
+#define ROUTE_CACHE_H
+
+#include "pareto.h"
+
+// =============================================================================================================
+// cache de frentes ja descobertas, por requisito de latencia, com validade (TTL) em segundos
+// =============================================================================================================
+
+#ifndef ROUTE_CACHE_SIZE
+#define ROUTE_CACHE_SIZE 2
+#endif
+
+#define ROUTE_CACHE_TTL 120
+
+struct route_cache_entry
+{
+  uint16_t requirement;
+  unsigned long expires; // 0: posicao vazia
+  struct pareto_front front;
+};
+
+// guarda (ou renova) a frente do requisito; cheio, substitui a entrada que vence primeiro
+void route_cache_store(uint16_t requirement, const struct pareto_front *front, unsigned long now);
+
+// frente ainda valida para o requisito, ou NULL
+const struct pareto_front *route_cache_lookup(uint16_t requirement, unsigned long now);
+
+// descarta as entradas com alguma alocacao que passa pelo enlace a-b; retorna quantas. Em affected,
+// quando nao NULL, fica o caminho da primeira alocacao atingida
+int route_cache_invalidate_link(node_id_t a, node_id_t b, struct path *affected);
+
+void route_cache_flush(void);
+
+#endif
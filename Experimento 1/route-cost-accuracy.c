@@ -0,0 +1,61 @@
+// =============================================================================================================
+// precisao do custo em ponto fixo contra a referencia em double (host)
+//
+// gcc -O2 -DROUTE_COST_REFERENCE -o route-cost-accuracy route-cost-accuracy.c route-cost.c -lm
+// =============================================================================================================
+
+#include "route-cost.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+int main()
+{
+
+  int latency, price, resource, count = 0;
+  double error, max_error = 0, sum_error = 0, fixed_s, reference_s, sink = 0;
+  int worst[3] = {0, 0, 0};
+  clock_t t;
+
+  for (latency = 1; latency <= 300; latency++)
+    for (price = 1; price <= 300; price += 3)
+      for (resource = 1; resource <= 20; resource++)
+      {
+
+        double reference = route_cost_reference(latency, price, resource);
+        double fixed = (double)route_cost(latency, price, resource) / ROUTE_COST_ONE;
+
+        error = fabs(fixed - reference) / reference;
+        sum_error += error;
+        count++;
+
+        if (error > max_error)
+        {
+          max_error = error;
+          worst[0] = latency;
+          worst[1] = price;
+          worst[2] = resource;
+        }
+      }
+
+  printf("%d entradas: erro relativo medio %.5f%%, maximo %.5f%% (L=%d P=%d R=%d)\n",
+         count, 100 * sum_error / count, 100 * max_error, worst[0], worst[1], worst[2]);
+
+  t = clock();
+  for (latency = 1; latency <= 1000000; latency++)
+    sink += route_cost(latency % 300 + 1, latency % 250 + 1, latency % 10 + 1);
+  fixed_s = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+  t = clock();
+  for (latency = 1; latency <= 1000000; latency++)
+    sink += route_cost_reference(latency % 300 + 1, latency % 250 + 1, latency % 10 + 1);
+  reference_s = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+  printf("host: ponto fixo %.1f ns, double %.1f ns por avaliacao\n", fixed_s * 1000, reference_s * 1000);
+
+  if (sink < 0)
+    printf("%f\n", sink);
+
+  return max_error > 0.01;
+}
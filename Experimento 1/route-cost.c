@@ -0,0 +1,124 @@
+#include "route-cost.h"
+
+#ifdef ROUTE_COST_REFERENCE
+#include <math.h>
+#endif
+
+// =============================================================================================================
+
+// log2(1 + i / 32) e 2^(i / 32) em Q16
+static const uint32_t log2_table[33] = {
+    0, 2909, 5732, 8473, 11136, 13727, 16248, 18704, 21098, 23433, 25711, 27936, 30109, 32234, 34312, 36346, 38336,
+    40286, 42196, 44068, 45904, 47705, 49472, 51207, 52911, 54584, 56229, 57845, 59434, 60997, 62534, 64047, 65536};
+
+static const uint32_t exp2_table[33] = {
+    65536, 66971, 68438, 69936, 71468, 73032, 74632, 76266, 77936, 79642, 81386, 83169, 84990, 86851, 88752, 90696,
+    92682, 94711, 96785, 98905, 101070, 103283, 105545, 107856, 110218, 112631, 115098, 117618, 120194, 122825,
+    125515, 128263, 131072};
+
+static struct route_cost_exponents exponents = {
+    ROUTE_COST_LATENCY_EXPONENT,
+    ROUTE_COST_PRICE_EXPONENT,
+    ROUTE_COST_RESOURCE_EXPONENT};
+
+// =============================================================================================================
+
+void route_cost_set_exponents(const struct route_cost_exponents *e)
+{
+  exponents = *e;
+}
+
+// =============================================================================================================
+
+int32_t route_cost_log2(uint32_t x)
+{
+
+  int n = 31;
+  uint32_t index, rest;
+
+  if (x == 0)
+    return 0;
+
+  while (!(x & 0xFF000000UL))
+  {
+    x <<= 8;
+    n -= 8;
+  }
+
+  while (!(x & 0x80000000UL))
+  {
+    x <<= 1;
+    n--;
+  }
+
+  // 5 bits apos o 1 mais significativo indexam a tabela, os 16 seguintes interpolam
+  index = (x >> 26) & 31;
+  rest = (x >> 10) & 0xFFFF;
+
+  return (((uint32_t)n << 16) + log2_table[index] +
+          (((log2_table[index + 1] - log2_table[index]) * rest) >> 16)) >>
+         (16 - ROUTE_COST_Q);
+}
+
+// =============================================================================================================
+
+route_cost_t route_cost_exp2(int32_t y)
+{
+
+  int32_t n = y >> ROUTE_COST_Q;
+  uint32_t f = y & ((1 << ROUTE_COST_Q) - 1),
+           index = f >> (ROUTE_COST_Q - 5),
+           rest = f & ((1 << (ROUTE_COST_Q - 5)) - 1),
+           v;
+
+  v = exp2_table[index] + (((exp2_table[index + 1] - exp2_table[index]) * rest) >> (ROUTE_COST_Q - 5));
+
+  if (n >= 0)
+    return (n >= 16) ? ROUTE_COST_MAX : v << n;
+
+  return (n <= -32) ? 0 : v >> -n;
+}
+
+// =============================================================================================================
+
+route_cost_t route_cost(int latency, int price, int resource)
+{
+
+  static int32_t log2_latency_scale, log2_price_scale;
+  int32_t y;
+
+  if (latency <= 0 || price <= 0)
+    return 0;
+
+  if (resource <= 0)
+    resource = 1;
+
+  if (log2_latency_scale == 0)
+  {
+    log2_latency_scale = route_cost_log2(ROUTE_COST_LATENCY_SCALE);
+    log2_price_scale = route_cost_log2(ROUTE_COST_PRICE_SCALE);
+  }
+
+  // cada termo e Q12 * Q12; a soma cabe em 32 bits para entradas de ate 16 bits
+  y = exponents.latency * (route_cost_log2(latency) - log2_latency_scale) +
+      exponents.price * (route_cost_log2(price) - log2_price_scale) -
+      exponents.resource * route_cost_log2(resource);
+
+  return route_cost_exp2(y / (1 << ROUTE_COST_Q));
+}
+
+// =============================================================================================================
+
+#ifdef ROUTE_COST_REFERENCE
+double route_cost_reference(int latency, int price, int resource)
+{
+
+  double fLatency = (double)latency / ROUTE_COST_LATENCY_SCALE;
+  double fPrice = (double)price / ROUTE_COST_PRICE_SCALE;
+  double fResouce = 1.0 / (resource <= 0 ? 1 : resource);
+
+  return pow(fLatency, exponents.latency / 4096.0) *
+         pow(fPrice, exponents.price / 4096.0) *
+         pow(fResouce, exponents.resource / 4096.0);
+}
+#endif
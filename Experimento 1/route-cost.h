@@ -0,0 +1,49 @@
+#ifndef ROUTE_COST_H
+#define ROUTE_COST_H
+
+#include <stdint.h>
+
+// =============================================================================================================
+// custo ponderado w = (latencia / 150)^0.7 * (preco / 20)^0.2 * (1 / recurso)^0.1 em ponto fixo
+//
+// os expoentes sao aplicados no dominio log2 (Q12) com tabelas de log2/exp2 interpoladas; o resultado
+// e um route_cost_t em Q16 (ROUTE_COST_ONE = 1.0)
+// =============================================================================================================
+
+typedef uint32_t route_cost_t;
+
+#define ROUTE_COST_ONE 65536UL
+#define ROUTE_COST_MAX 0xFFFFFFFFUL
+
+#define ROUTE_COST_Q 12
+
+#define ROUTE_COST_LATENCY_SCALE 150
+#define ROUTE_COST_PRICE_SCALE 20
+
+// expoentes padrao em Q12
+#define ROUTE_COST_LATENCY_EXPONENT 2867 // 0.7
+#define ROUTE_COST_PRICE_EXPONENT 819    // 0.2
+#define ROUTE_COST_RESOURCE_EXPONENT 410 // 0.1
+
+struct route_cost_exponents
+{
+  int16_t latency, price, resource;
+};
+
+void route_cost_set_exponents(const struct route_cost_exponents *exponents);
+
+// preco 0 ou latencia 0 resultam em custo 0; recurso 0 e tratado como 1
+route_cost_t route_cost(int latency, int price, int resource);
+
+// log2(x) em Q12 para x >= 1
+int32_t route_cost_log2(uint32_t x);
+
+// 2^(y / 4096) em Q16, saturando em ROUTE_COST_MAX
+route_cost_t route_cost_exp2(int32_t y);
+
+#ifdef ROUTE_COST_REFERENCE
+// implementacao original em double, para comparacao de precisao e de ciclos
+double route_cost_reference(int latency, int price, int resource);
+#endif
+
+#endif
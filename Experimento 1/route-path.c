@@ -0,0 +1,104 @@
+#include "route-path.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// =============================================================================================================
+
+void path_clear(struct path *path)
+{
+  memset(path, 0, sizeof(struct path));
+}
+
+// =============================================================================================================
+
+int path_contains(const struct path *path, node_id_t vertex)
+{
+  if (vertex == 0 || vertex > MAXIMUM_DEVICES)
+    return 0;
+
+  return (path->visited[vertex >> 3] >> (vertex & 7)) & 1;
+}
+
+// =============================================================================================================
+
+int path_append(struct path *path, node_id_t vertex)
+{
+
+  if (path->length == MAXIMUM_HOPS || vertex == 0 || vertex > MAXIMUM_DEVICES)
+    return 0;
+
+  path->hop[path->length++] = vertex;
+  path->visited[vertex >> 3] |= 1 << (vertex & 7);
+
+  return 1;
+}
+
+// =============================================================================================================
+
+node_id_t path_father(const struct path *path, node_id_t vertex)
+{
+
+  int i;
+
+  if (!path_contains(path, vertex))
+    return 0;
+
+  for (i = 1; i < path->length; i++)
+    if (path->hop[i] == vertex)
+      return path->hop[i - 1];
+
+  return 0;
+}
+
+// =============================================================================================================
+
+node_id_t path_child(const struct path *path, node_id_t vertex)
+{
+
+  int i;
+
+  if (!path_contains(path, vertex))
+    return 0;
+
+  for (i = 0; i + 1 < path->length; i++)
+    if (path->hop[i] == vertex)
+      return path->hop[i + 1];
+
+  return 0;
+}
+
+// =============================================================================================================
+
+int path_equal(const struct path *a, const struct path *b)
+{
+  return a->length == b->length && memcmp(a->hop, b->hop, a->length * sizeof(node_id_t)) == 0;
+}
+
+// =============================================================================================================
+
+int path_uses_link(const struct path *path, node_id_t a, node_id_t b)
+{
+
+  int i;
+
+  if (!path_contains(path, a) || !path_contains(path, b))
+    return 0;
+
+  for (i = 1; i < path->length; i++)
+    if ((path->hop[i - 1] == a && path->hop[i] == b) || (path->hop[i - 1] == b && path->hop[i] == a))
+      return 1;
+
+  return 0;
+}
+
+// =============================================================================================================
+
+void print_path(const struct path *path)
+{
+
+  int i;
+
+  for (i = 0; i < path->length; i++)
+    printf("%u-", path->hop[i]);
+}
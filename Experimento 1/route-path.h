@@ -0,0 +1,52 @@
+#ifndef ROUTE_PATH_H
+#define ROUTE_PATH_H
+
+#include <stdint.h>
+
+// =============================================================================================================
+// caminho em binario: vertices na ordem de visita e bitmap indexado pelo id do vertice
+// =============================================================================================================
+
+// capacidades em tempo de compilacao: make MAXIMUM_DEVICES=512 MAXIMUM_HOPS=24
+#ifndef MAXIMUM_DEVICES
+#define MAXIMUM_DEVICES 30
+#endif
+
+#ifndef MAXIMUM_HOPS
+#define MAXIMUM_HOPS 16
+#endif
+
+#define VISITED_BYTES ((MAXIMUM_DEVICES + 8) / 8)
+
+// id do vertice: os dois bytes do endereco Rime (id do mote no Cooja); 0 nao e vertice
+typedef uint16_t node_id_t;
+
+struct path
+{
+  uint8_t length;
+  node_id_t hop[MAXIMUM_HOPS];
+  uint8_t visited[VISITED_BYTES];
+};
+
+void path_clear(struct path *path);
+
+int path_contains(const struct path *path, node_id_t vertex);
+
+// retorna 0 quando o caminho esta cheio ou o vertice esta fora de 1..MAXIMUM_DEVICES
+int path_append(struct path *path, node_id_t vertex);
+
+// vertice anterior a vertex no caminho, ou 0
+node_id_t path_father(const struct path *path, node_id_t vertex);
+
+// vertice seguinte a vertex no caminho, ou 0
+node_id_t path_child(const struct path *path, node_id_t vertex);
+
+int path_equal(const struct path *a, const struct path *b);
+
+// 1 se a e b aparecem em sequencia no caminho, em qualquer ordem
+int path_uses_link(const struct path *path, node_id_t a, node_id_t b);
+
+// imprime no formato "1-2-3-"
+void print_path(const struct path *path);
+
+#endif
@@ -0,0 +1,605 @@
+#include "contiki.h"
+
+#include "lib/list.h"
+#include "lib/memb.h"
+#include "lib/random.h"
+#include "dev/serial-line.h"
+#include "net/rime/rime.h"
+
+#include "node.h"
+
+#include <string.h>
+
+// =============================================================================================================
+// contiki do no simulado: todo o estado fica neste .so e e trocado pelo route-sim a cada no, como nos motes
+// nativos do Cooja
+// =============================================================================================================
+
+#define EVENT_QUEUE_SIZE 32
+#define SENT_QUEUE_SIZE 16
+#define SERIAL_LINE_SIZE 128
+
+struct event
+{
+  process_event_t ev;
+  process_data_t data;
+  struct process *p;
+};
+
+struct sent
+{
+  void *conn;
+  int unicast;
+};
+
+// -------------------------------------------------------------------------------------------------------------
+
+struct process *process_current;
+process_event_t serial_line_event_message;
+
+linkaddr_t linkaddr_node_addr;
+const linkaddr_t linkaddr_null;
+
+static struct process *process_list;
+static process_event_t last_event = PROCESS_EVENT_TIMER;
+
+static struct event events[EVENT_QUEUE_SIZE];
+static int events_head, events_length;
+
+static struct sent sent[SENT_QUEUE_SIZE];
+static int sent_length;
+
+static struct etimer *timer_list;
+
+static struct broadcast_conn *broadcast_conns;
+static struct unicast_conn *unicast_conns;
+
+static uint8_t packetbuf[PACKETBUF_SIZE];
+static unsigned short packetbuf_length;
+
+static char serial_line[SERIAL_LINE_SIZE];
+
+static unsigned short random_state;
+
+// =============================================================================================================
+
+clock_time_t clock_time(void)
+{
+  return sim_now() * CLOCK_SECOND / 1000000;
+}
+
+unsigned long clock_seconds(void)
+{
+  return sim_now() / 1000000;
+}
+
+rtimer_clock_t rtimer_now(void)
+{
+  return (rtimer_clock_t)sim_now();
+}
+
+// =============================================================================================================
+
+// gerador congruente de 16 bits do lib/random.c do Contiki
+
+void random_init(unsigned short seed)
+{
+  random_state = seed;
+}
+
+unsigned short random_rand(void)
+{
+  random_state = random_state * 2053 + 13849;
+  return random_state;
+}
+
+// =============================================================================================================
+
+int linkaddr_cmp(const linkaddr_t *a, const linkaddr_t *b)
+{
+  return a->u8[0] == b->u8[0] && a->u8[1] == b->u8[1];
+}
+
+void linkaddr_copy(linkaddr_t *dest, const linkaddr_t *from)
+{
+  dest->u8[0] = from->u8[0];
+  dest->u8[1] = from->u8[1];
+}
+
+static uint16_t address_id(const linkaddr_t *address)
+{
+  return address->u8[0] | (uint16_t)address->u8[1] << 8;
+}
+
+// =============================================================================================================
+
+void list_init(list_t list)
+{
+  *list = NULL;
+}
+
+void *list_head(list_t list)
+{
+  return *list;
+}
+
+void *list_item_next(void *item)
+{
+  return item == NULL ? NULL : *(void **)item;
+}
+
+void *list_tail(list_t list)
+{
+
+  void **l;
+
+  if (*list == NULL)
+    return NULL;
+
+  for (l = *list; *l != NULL; l = *l)
+    ;
+
+  return l;
+}
+
+void list_remove(list_t list, void *item)
+{
+
+  void **l, **previous = NULL;
+
+  for (l = *list; l != NULL; l = *l)
+  {
+    if (l == item)
+    {
+      if (previous == NULL)
+        *list = *l;
+      else
+        *previous = *l;
+
+      *l = NULL;
+      return;
+    }
+
+    previous = l;
+  }
+}
+
+void list_add(list_t list, void *item)
+{
+
+  void **tail;
+
+  list_remove(list, item);
+  *(void **)item = NULL;
+
+  tail = list_tail(list);
+
+  if (tail == NULL)
+    *list = item;
+  else
+    *tail = item;
+}
+
+void list_push(list_t list, void *item)
+{
+  list_remove(list, item);
+  *(void **)item = *list;
+  *list = item;
+}
+
+void *list_pop(list_t list)
+{
+
+  void **l = *list;
+
+  if (l != NULL)
+    list_remove(list, l);
+
+  return l;
+}
+
+int list_length(list_t list)
+{
+
+  void **l;
+  int n = 0;
+
+  for (l = *list; l != NULL; l = *l)
+    n++;
+
+  return n;
+}
+
+// =============================================================================================================
+
+void memb_init(struct memb *m)
+{
+  memset(m->count, 0, m->num);
+}
+
+void *memb_alloc(struct memb *m)
+{
+
+  int i;
+
+  for (i = 0; i < m->num; i++)
+  {
+    if (m->count[i] == 0)
+    {
+      m->count[i] = 1;
+      return (char *)m->mem + i * m->size;
+    }
+  }
+
+  return NULL;
+}
+
+char memb_free(struct memb *m, void *ptr)
+{
+
+  int i = ((char *)ptr - (char *)m->mem) / m->size;
+
+  if (i < 0 || i >= m->num)
+    return -1;
+
+  m->count[i] = 0;
+  return 0;
+}
+
+// =============================================================================================================
+
+void packetbuf_clear(void)
+{
+  packetbuf_length = 0;
+}
+
+void *packetbuf_dataptr(void)
+{
+  return packetbuf;
+}
+
+int packetbuf_copyfrom(const void *from, unsigned short length)
+{
+  packetbuf_length = length < PACKETBUF_SIZE ? length : PACKETBUF_SIZE;
+  memcpy(packetbuf, from, packetbuf_length);
+
+  return packetbuf_length;
+}
+
+unsigned short packetbuf_datalen(void)
+{
+  return packetbuf_length;
+}
+
+void packetbuf_set_datalen(unsigned short length)
+{
+  packetbuf_length = length;
+}
+
+// =============================================================================================================
+
+static void call_process(struct process *p, process_event_t ev, process_data_t data)
+{
+
+  struct process *caller = process_current;
+
+  if (p->state == 0 || p->thread == NULL)
+    return;
+
+  process_current = p;
+
+  if (p->thread(&p->pt, ev, data) >= PT_EXITED)
+  {
+    p->state = 0;
+    list_remove((list_t)&process_list, p);
+  }
+
+  process_current = caller;
+}
+
+void process_start(struct process *p, process_data_t data)
+{
+
+  struct process *q;
+
+  for (q = process_list; q != NULL; q = q->next)
+    if (q == p)
+      return;
+
+  p->next = process_list;
+  process_list = p;
+  p->state = 1;
+  p->needspoll = 0;
+  p->pt.lc = 0;
+
+  call_process(p, PROCESS_EVENT_INIT, data);
+}
+
+int process_post(struct process *p, process_event_t ev, process_data_t data)
+{
+
+  struct event *e;
+
+  if (events_length == EVENT_QUEUE_SIZE)
+    return 1;
+
+  e = &events[(events_head + events_length++) % EVENT_QUEUE_SIZE];
+  e->ev = ev;
+  e->data = data;
+  e->p = p;
+
+  return 0;
+}
+
+void process_poll(struct process *p)
+{
+  if (p != NULL)
+    p->needspoll = 1;
+}
+
+process_event_t process_alloc_event(void)
+{
+  return ++last_event;
+}
+
+// =============================================================================================================
+
+static clock_time_t timer_deadline(struct etimer *et)
+{
+  return et->timer.start + et->timer.interval;
+}
+
+void etimer_set(struct etimer *et, clock_time_t interval)
+{
+  et->timer.start = clock_time();
+  et->timer.interval = interval;
+  et->p = process_current;
+
+  list_add((list_t)&timer_list, et);
+}
+
+void etimer_stop(struct etimer *et)
+{
+  list_remove((list_t)&timer_list, et);
+  et->p = PROCESS_NONE;
+}
+
+int etimer_expired(struct etimer *et)
+{
+  return et->p == PROCESS_NONE;
+}
+
+// =============================================================================================================
+
+void broadcast_open(struct broadcast_conn *c, uint16_t channel, const struct broadcast_callbacks *u)
+{
+  c->channel = channel;
+  c->u = u;
+  list_add((list_t)&broadcast_conns, c);
+}
+
+void broadcast_close(struct broadcast_conn *c)
+{
+  list_remove((list_t)&broadcast_conns, c);
+}
+
+void unicast_open(struct unicast_conn *c, uint16_t channel, const struct unicast_callbacks *u)
+{
+  c->channel = channel;
+  c->u = u;
+  list_add((list_t)&unicast_conns, c);
+}
+
+void unicast_close(struct unicast_conn *c)
+{
+  list_remove((list_t)&unicast_conns, c);
+}
+
+// o callback sent roda depois do processo atual, como apos a transmissao pelo MAC
+
+static void queue_sent(void *conn, int unicast)
+{
+  if (sent_length < SENT_QUEUE_SIZE)
+  {
+    sent[sent_length].conn = conn;
+    sent[sent_length].unicast = unicast;
+    sent_length++;
+  }
+}
+
+int broadcast_send(struct broadcast_conn *c)
+{
+  sim_transmit(c->channel, 0, 0, packetbuf, packetbuf_length);
+  queue_sent(c, 0);
+
+  return 1;
+}
+
+int unicast_send(struct unicast_conn *c, const linkaddr_t *receiver)
+{
+  sim_transmit(c->channel, 1, address_id(receiver), packetbuf, packetbuf_length);
+  queue_sent(c, 1);
+
+  return 1;
+}
+
+// =============================================================================================================
+
+void node_boot(uint16_t id, unsigned short seed)
+{
+
+  extern struct process *const autostart_processes[];
+  int i;
+
+  linkaddr_node_addr.u8[0] = id & 0xff;
+  linkaddr_node_addr.u8[1] = id >> 8;
+
+  random_init(seed);
+  serial_line_event_message = process_alloc_event();
+
+  for (i = 0; autostart_processes[i] != NULL; i++)
+    process_start(autostart_processes[i], NULL);
+
+  node_run();
+}
+
+// =============================================================================================================
+
+static int run_once(void)
+{
+
+  struct etimer *et, *next;
+  struct process *p;
+  struct event e;
+  int i, worked = 0;
+
+  for (et = timer_list; et != NULL; et = next)
+  {
+    next = et->next;
+
+    if (timer_deadline(et) <= clock_time())
+    {
+      p = et->p;
+      list_remove((list_t)&timer_list, et);
+      et->p = PROCESS_NONE;
+
+      if (p != NULL)
+        process_post(p, PROCESS_EVENT_TIMER, et);
+      worked = 1;
+    }
+  }
+
+  for (p = process_list; p != NULL; p = p->next)
+  {
+    if (p->needspoll)
+    {
+      p->needspoll = 0;
+      call_process(p, PROCESS_EVENT_POLL, NULL);
+      worked = 1;
+    }
+  }
+
+  if (events_length > 0)
+  {
+    e = events[events_head];
+    events_head = (events_head + 1) % EVENT_QUEUE_SIZE;
+    events_length--;
+
+    if (e.p == PROCESS_BROADCAST)
+    {
+      for (p = process_list; p != NULL; p = p->next)
+        call_process(p, e.ev, e.data);
+    }
+    else
+      call_process(e.p, e.ev, e.data);
+
+    worked = 1;
+  }
+
+  for (i = 0; i < sent_length; i++)
+  {
+    if (sent[i].unicast)
+    {
+      struct unicast_conn *c = sent[i].conn;
+
+      if (c->u->sent != NULL)
+        c->u->sent(c, MAC_TX_OK, 1);
+    }
+    else
+    {
+      struct broadcast_conn *c = sent[i].conn;
+
+      if (c->u->sent != NULL)
+        c->u->sent(c, MAC_TX_OK, 1);
+    }
+
+    worked = 1;
+  }
+
+  sent_length = 0;
+
+  return worked;
+}
+
+void node_run(void)
+{
+  while (run_once())
+    ;
+}
+
+// =============================================================================================================
+
+uint64_t node_next_timer(void)
+{
+
+  struct etimer *et;
+  clock_time_t deadline = 0;
+  int found = 0;
+
+  for (et = timer_list; et != NULL; et = et->next)
+  {
+    if (!found || timer_deadline(et) < deadline)
+    {
+      deadline = timer_deadline(et);
+      found = 1;
+    }
+  }
+
+  if (!found)
+    return NODE_IDLE;
+
+  // primeiro microssegundo em que clock_time() alcanca o prazo
+  return ((uint64_t)deadline * 1000000 + CLOCK_SECOND - 1) / CLOCK_SECOND;
+}
+
+// =============================================================================================================
+
+void node_receive(uint16_t channel, int unicast, uint16_t from, const void *data, int length)
+{
+
+  linkaddr_t sender;
+
+  sender.u8[0] = from & 0xff;
+  sender.u8[1] = from >> 8;
+
+  if (unicast)
+  {
+    struct unicast_conn *c;
+
+    for (c = unicast_conns; c != NULL; c = c->next)
+    {
+      if (c->channel == channel)
+      {
+        packetbuf_copyfrom(data, length);
+        c->u->recv(c, &sender);
+        break;
+      }
+    }
+  }
+  else
+  {
+    struct broadcast_conn *c;
+
+    for (c = broadcast_conns; c != NULL; c = c->next)
+    {
+      if (c->channel == channel)
+      {
+        packetbuf_copyfrom(data, length);
+        c->u->recv(c, &sender);
+        break;
+      }
+    }
+  }
+
+  node_run();
+}
+
+// =============================================================================================================
+
+void node_serial(const char *line)
+{
+  strncpy(serial_line, line, SERIAL_LINE_SIZE - 1);
+  process_post(PROCESS_BROADCAST, serial_line_event_message, serial_line);
+
+  node_run();
+}
@@ -0,0 +1,6 @@
+#ifndef CC2420_H
+#define CC2420_H
+
+// o radio e o modelo em memoria do route-sim: nada do driver e usado
+
+#endif
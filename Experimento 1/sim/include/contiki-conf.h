@@ -0,0 +1,12 @@
+#ifndef CONTIKI_CONF_H
+#define CONTIKI_CONF_H
+
+// relogio e CPU do Sky, para que os tempos e o COST_BENCHMARK usem as mesmas escalas do alvo
+#define CLOCK_CONF_SECOND 128UL
+#define CLOCK_SECOND CLOCK_CONF_SECOND
+
+#define F_CPU 3900000UL
+
+#define PACKETBUF_CONF_SIZE 128
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef CONTIKI_H
+#define CONTIKI_H
+
+// =============================================================================================================
+// contiki minimo para o simulador: so o que firmware.c e link-latency.c usam, com a mesma semantica
+// (protothreads, processos, etimer, rtimer, broadcast/unicast do Rime, packetbuf, list e memb)
+// =============================================================================================================
+
+#include "contiki-conf.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// -------------------------------------------------------------------------------------------------------------
+// relogios
+
+typedef unsigned long clock_time_t;
+
+clock_time_t clock_time(void);
+unsigned long clock_seconds(void);
+
+// rtimer em microssegundos e 32 bits: a ida e volta de varias centenas de ms nao da a volta no contador
+typedef uint32_t rtimer_clock_t;
+
+#define RTIMER_SECOND 1000000UL
+#define RTIMER_NOW() rtimer_now()
+
+rtimer_clock_t rtimer_now(void);
+
+// -------------------------------------------------------------------------------------------------------------
+// protothreads (lc-switch, como em sys/pt.h)
+
+struct pt
+{
+  unsigned short lc;
+};
+
+#define PT_WAITING 0
+#define PT_YIELDED 1
+#define PT_EXITED 2
+#define PT_ENDED 3
+
+#define PT_THREAD(name_args) char name_args
+
+#define LC_SET(s) \
+  s = __LINE__;   \
+  case __LINE__:
+
+#define PT_BEGIN(pt)            \
+  {                             \
+    char PT_YIELD_FLAG = 1;     \
+    if (PT_YIELD_FLAG)          \
+    {                           \
+      ;                         \
+    }                           \
+    switch ((pt)->lc)           \
+    {                           \
+    case 0:
+
+#define PT_END(pt)         \
+  }                        \
+  PT_YIELD_FLAG = 0;       \
+  (pt)->lc = 0;            \
+  return PT_ENDED;         \
+  }
+
+#define PT_WAIT_UNTIL(pt, condition) \
+  do                                 \
+  {                                  \
+    LC_SET((pt)->lc);                \
+    if (!(condition))                \
+      return PT_WAITING;             \
+  } while (0)
+
+#define PT_YIELD_UNTIL(pt, condition)            \
+  do                                             \
+  {                                              \
+    PT_YIELD_FLAG = 0;                           \
+    LC_SET((pt)->lc);                            \
+    if ((PT_YIELD_FLAG == 0) || !(condition))    \
+      return PT_YIELDED;                         \
+  } while (0)
+
+#define PT_EXIT(pt)   \
+  do                  \
+  {                   \
+    (pt)->lc = 0;     \
+    return PT_EXITED; \
+  } while (0)
+
+// -------------------------------------------------------------------------------------------------------------
+// processos
+
+typedef unsigned char process_event_t;
+typedef void *process_data_t;
+
+struct process
+{
+  struct process *next;
+  const char *name;
+  PT_THREAD((*thread)(struct pt *, process_event_t, process_data_t));
+  struct pt pt;
+  unsigned char state, needspoll;
+};
+
+#define PROCESS_EVENT_INIT 0x81
+#define PROCESS_EVENT_POLL 0x82
+#define PROCESS_EVENT_EXIT 0x83
+#define PROCESS_EVENT_CONTINUE 0x85
+#define PROCESS_EVENT_MSG 0x86
+#define PROCESS_EVENT_TIMER 0x88
+
+#define PROCESS_BROADCAST NULL
+#define PROCESS_NONE NULL
+
+#define PROCESS_THREAD(name, ev, data) \
+  static PT_THREAD(process_thread_##name(struct pt *process_pt, process_event_t ev, process_data_t data))
+
+#define PROCESS_NAME(name) extern struct process name
+
+#define PROCESS(name, strname)      \
+  PROCESS_THREAD(name, ev, data);   \
+  struct process name = {NULL, strname, process_thread_##name, {0}, 0, 0}
+
+#define AUTOSTART_PROCESSES(...) struct process *const autostart_processes[] = {__VA_ARGS__, NULL}
+
+#define PROCESS_BEGIN() PT_BEGIN(process_pt)
+#define PROCESS_END() PT_END(process_pt)
+#define PROCESS_WAIT_EVENT() PROCESS_YIELD()
+#define PROCESS_WAIT_EVENT_UNTIL(c) PROCESS_YIELD_UNTIL(c)
+#define PROCESS_YIELD() PT_YIELD_UNTIL(process_pt, 1)
+#define PROCESS_YIELD_UNTIL(c) PT_YIELD_UNTIL(process_pt, c)
+#define PROCESS_WAIT_UNTIL(c) PT_WAIT_UNTIL(process_pt, c)
+#define PROCESS_EXIT() PT_EXIT(process_pt)
+#define PROCESS_EXITHANDLER(handler) \
+  if (ev == PROCESS_EVENT_EXIT)      \
+  {                                  \
+    handler;                         \
+  }
+
+#define PROCESS_PAUSE()                                              \
+  do                                                                 \
+  {                                                                  \
+    process_post(PROCESS_CURRENT(), PROCESS_EVENT_CONTINUE, NULL);   \
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_CONTINUE);          \
+  } while (0)
+
+#define PROCESS_CURRENT() process_current
+
+extern struct process *process_current;
+
+void process_start(struct process *p, process_data_t data);
+int process_post(struct process *p, process_event_t ev, process_data_t data);
+void process_poll(struct process *p);
+process_event_t process_alloc_event(void);
+
+// -------------------------------------------------------------------------------------------------------------
+// etimer
+
+struct timer
+{
+  clock_time_t start, interval;
+};
+
+// next primeiro, para que o etimer entre nas listas de lib/list.h
+struct etimer
+{
+  struct etimer *next;
+  struct timer timer;
+  struct process *p;
+};
+
+void etimer_set(struct etimer *et, clock_time_t interval);
+void etimer_stop(struct etimer *et);
+int etimer_expired(struct etimer *et);
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef SERIAL_LINE_H
+#define SERIAL_LINE_H
+
+#include "contiki.h"
+
+extern process_event_t serial_line_event_message;
+
+#endif
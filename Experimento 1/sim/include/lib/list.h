@@ -0,0 +1,20 @@
+#ifndef LIST_H
+#define LIST_H
+
+#define LIST(name)                      \
+  static void *name##_list = NULL;      \
+  static list_t name = (list_t)&name##_list
+
+typedef void **list_t;
+
+void list_init(list_t list);
+void *list_head(list_t list);
+void *list_tail(list_t list);
+void *list_pop(list_t list);
+void list_push(list_t list, void *item);
+void list_add(list_t list, void *item);
+void list_remove(list_t list, void *item);
+int list_length(list_t list);
+void *list_item_next(void *item);
+
+#endif
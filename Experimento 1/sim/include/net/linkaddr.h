@@ -0,0 +1,18 @@
+#ifndef LINKADDR_H
+#define LINKADDR_H
+
+#include <stdint.h>
+
+typedef union
+{
+  unsigned char u8[2];
+  uint16_t u16;
+} linkaddr_t;
+
+extern linkaddr_t linkaddr_node_addr;
+extern const linkaddr_t linkaddr_null;
+
+int linkaddr_cmp(const linkaddr_t *a, const linkaddr_t *b);
+void linkaddr_copy(linkaddr_t *dest, const linkaddr_t *from);
+
+#endif
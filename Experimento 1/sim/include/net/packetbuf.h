@@ -0,0 +1,14 @@
+#ifndef PACKETBUF_H
+#define PACKETBUF_H
+
+#include "contiki-conf.h"
+
+#define PACKETBUF_SIZE PACKETBUF_CONF_SIZE
+
+void packetbuf_clear(void);
+void *packetbuf_dataptr(void);
+int packetbuf_copyfrom(const void *from, unsigned short len);
+unsigned short packetbuf_datalen(void);
+void packetbuf_set_datalen(unsigned short len);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef RIME_H
+#define RIME_H
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+#include "net/packetbuf.h"
+
+// broadcast e unicast do Rime sobre o radio do simulador; o canal separa as conexoes como no Rime
+
+#define MAC_TX_OK 0
+
+struct broadcast_conn;
+struct unicast_conn;
+
+struct broadcast_callbacks
+{
+  void (*recv)(struct broadcast_conn *c, const linkaddr_t *from);
+  void (*sent)(struct broadcast_conn *c, int status, int num_tx);
+};
+
+struct unicast_callbacks
+{
+  void (*recv)(struct unicast_conn *c, const linkaddr_t *from);
+  void (*sent)(struct unicast_conn *c, int status, int num_tx);
+};
+
+struct broadcast_conn
+{
+  struct broadcast_conn *next;
+  uint16_t channel;
+  const struct broadcast_callbacks *u;
+};
+
+struct unicast_conn
+{
+  struct unicast_conn *next;
+  uint16_t channel;
+  const struct unicast_callbacks *u;
+};
+
+void broadcast_open(struct broadcast_conn *c, uint16_t channel, const struct broadcast_callbacks *u);
+void broadcast_close(struct broadcast_conn *c);
+int broadcast_send(struct broadcast_conn *c);
+
+void unicast_open(struct unicast_conn *c, uint16_t channel, const struct unicast_callbacks *u);
+void unicast_close(struct unicast_conn *c);
+int unicast_send(struct unicast_conn *c, const linkaddr_t *receiver);
+
+#endif
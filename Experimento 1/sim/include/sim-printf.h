@@ -0,0 +1,12 @@
+#ifndef SIM_PRINTF_H
+#define SIM_PRINTF_H
+
+// incluido antes de cada fonte do firmware-sim.so: a saida do no vai para o route-sim, como o serial do Cooja
+
+#include <stdio.h>
+
+int sim_printf(const char *format, ...);
+
+#define printf sim_printf
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef NODE_H
+#define NODE_H
+
+#include <stdint.h>
+
+// =============================================================================================================
+// fronteira entre o route-sim e o firmware-sim.so (firmware.c + contiki-host.c)
+// =============================================================================================================
+
+#define NODE_IDLE UINT64_MAX
+
+// chamadas do route-sim, sempre com a memoria do no ja carregada
+
+void node_boot(uint16_t id, unsigned short seed);
+
+// processa eventos, polls e etimers vencidos ate o no ficar ocioso
+void node_run(void);
+
+// instante (us) do proximo etimer, ou NODE_IDLE
+uint64_t node_next_timer(void);
+
+void node_receive(uint16_t channel, int unicast, uint16_t from, const void *data, int length);
+
+// linha do serial, sem o '\n' (serial_line_event_message para todos os processos)
+void node_serial(const char *line);
+
+// chamadas do firmware-sim.so para o route-sim
+
+uint64_t sim_now(void);
+
+void sim_transmit(uint16_t channel, int unicast, uint16_t to, const void *data, int length);
+
+int sim_printf(const char *format, ...);
+
+#endif
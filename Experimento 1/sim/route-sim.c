@@ -0,0 +1,803 @@
+#define _GNU_SOURCE
+
+#include "node.h"
+
+#include "../route-cost.h"
+#include "../route-path.h"
+
+#include <dlfcn.h>
+#include <link.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// =============================================================================================================
+// simulador de eventos discretos da descoberta de rotas
+//
+// o firmware (firmware.c e modulos, sem alteracao) roda em firmware-sim.so sobre contiki-host.c; como nos motes
+// nativos do Cooja, o segmento gravavel do .so e trocado a cada no. O radio e uma matriz de latencias: um quadro
+// chega a cada vizinho depois da latencia do enlace, sem perdas; quadros que se sobrepoem no receptor (pelo
+// tempo no ar a 250 kbit/s) sao contados como colisoes, mas entregues. Cada topologia aleatoria e comparada com
+// a alocacao otima calculada por Dijkstra
+//
+// com -x, depois da solucao o ultimo enlace da rota escolhida fica fator vezes mais lento e a simulacao segue
+// por REACTION_WINDOW; custo e otimo passam a ser os da topologia alterada e reaction diz o que DEVICE_D fez
+//
+// uso: route-sim [-n motes] [-t topologias] [-j processos] [-s semente] [-d vizinhos] [-l latencia_max_ms]
+//                [-T limite_s] [-S silencio_s] [-W aquecimento_s] [-x fator] [-L rotulo] [-f firmware-sim.so]
+//                [-v]
+// =============================================================================================================
+
+#ifndef LATENCY_REQUIREMENT
+#define LATENCY_REQUIREMENT 20
+#endif
+
+#define DEVICE_D 1
+#define MAX_SEGMENTS 4
+#define REACTION_WINDOW 240
+
+// tempo no ar por byte a 250 kbit/s e cabecalhos do 802.15.4 e do Rime, em microssegundos e bytes
+#define AIRTIME_PER_BYTE 32
+#define FRAME_OVERHEAD 17
+
+enum
+{
+  WAKE,
+  DELIVER,
+  SERIAL
+};
+
+struct event
+{
+  uint64_t time, sequence;
+  int type, node;
+  uint16_t channel, from;
+  int unicast, length;
+  char *data;
+};
+
+struct segment
+{
+  uint8_t *start;
+  size_t size;
+};
+
+struct mote
+{
+  uint8_t *memory;
+  uint64_t wake, busy_until;
+  int price, resource;
+  char line[256];
+  int line_length;
+};
+
+struct profile
+{
+  const char *kind;
+  int price, resource;
+};
+
+// mesmos perfis do cenario.js e do benchmark.js
+static const struct profile profiles[] = {
+    {"mist", 0, 3}, {"mist", 0, 5}, {"fog", 0, 15}, {"fog", 0, 20}, {"cloud", 5, 200}, {"cloud", 10, 250}};
+
+// =============================================================================================================
+
+static int motes_count = 20, topologies = 100, workers, density = 6, max_latency = 8, slowdown, verbose;
+static unsigned long base_seed = 1;
+static uint64_t limit = 1800, settle = 30, warmup = 30;
+static const char *label = "dfs", *firmware = "./firmware-sim.so";
+
+static void (*boot)(uint16_t, unsigned short);
+static void (*receive)(uint16_t, int, uint16_t, const void *, int);
+static void (*serial)(const char *);
+static void (*run)(void);
+static uint64_t (*next_timer)(void);
+
+static struct segment segments[MAX_SEGMENTS];
+static int segment_count;
+static size_t memory_size;
+static uint8_t *initial_memory;
+static ElfW(Addr) library_base;
+
+static struct mote *motes;
+static int loaded, current;
+static uint8_t *latency;
+
+static struct event *heap;
+static int heap_length, heap_capacity;
+static uint64_t now, sequence;
+
+// saida de DEVICE_D e contadores da execucao atual
+static uint64_t finished_at;
+static int solved, messages, collisions;
+static unsigned long found_cost;
+static int found_latency;
+static char found_route[128];
+static const char *reaction;
+
+static unsigned long random_state;
+
+// =============================================================================================================
+
+static unsigned long next_random(void)
+{
+  random_state = random_state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return random_state >> 33;
+}
+
+// =============================================================================================================
+
+uint64_t sim_now(void)
+{
+  return now;
+}
+
+static void push(struct event *e)
+{
+
+  int i;
+
+  if (heap_length == heap_capacity)
+  {
+    heap_capacity = heap_capacity ? 2 * heap_capacity : 1024;
+    heap = realloc(heap, heap_capacity * sizeof(struct event));
+  }
+
+  e->sequence = sequence++;
+
+  for (i = heap_length++; i > 0; i = (i - 1) / 2)
+  {
+    struct event *parent = &heap[(i - 1) / 2];
+
+    if (parent->time < e->time || (parent->time == e->time && parent->sequence < e->sequence))
+      break;
+
+    heap[i] = *parent;
+  }
+
+  heap[i] = *e;
+}
+
+static struct event pop(void)
+{
+
+  struct event top = heap[0], last = heap[--heap_length];
+  int i = 0, child;
+
+  while ((child = 2 * i + 1) < heap_length)
+  {
+    if (child + 1 < heap_length &&
+        (heap[child + 1].time < heap[child].time ||
+         (heap[child + 1].time == heap[child].time && heap[child + 1].sequence < heap[child].sequence)))
+      child++;
+
+    if (last.time < heap[child].time || (last.time == heap[child].time && last.sequence < heap[child].sequence))
+      break;
+
+    heap[i] = heap[child];
+    i = child;
+  }
+
+  heap[i] = last;
+  return top;
+}
+
+// =============================================================================================================
+
+// troca a memoria do .so: guarda a do no carregado e copia a do no pedido
+
+static void load(int node)
+{
+
+  int i;
+  size_t offset;
+
+  if (loaded == node)
+    return;
+
+  if (loaded >= 0)
+    for (i = 0, offset = 0; i < segment_count; offset += segments[i++].size)
+      memcpy(motes[loaded].memory + offset, segments[i].start, segments[i].size);
+
+  for (i = 0, offset = 0; i < segment_count; offset += segments[i++].size)
+    memcpy(segments[i].start, motes[node].memory + offset, segments[i].size);
+
+  loaded = node;
+}
+
+static void schedule_wake(int node)
+{
+
+  struct event e;
+  uint64_t wake = next_timer();
+
+  if (wake >= motes[node].wake)
+    return;
+
+  motes[node].wake = wake;
+
+  memset(&e, 0, sizeof(e));
+  e.type = WAKE;
+  e.node = node;
+  e.time = wake > now ? wake : now;
+  push(&e);
+}
+
+// =============================================================================================================
+
+void sim_transmit(uint16_t channel, int unicast, uint16_t to, const void *data, int length)
+{
+
+  struct event e;
+  int v;
+
+  for (v = 1; v <= motes_count; v++)
+  {
+
+    if (v == current || latency[current * (motes_count + 1) + v] == 0 || (unicast && v != to))
+      continue;
+
+    memset(&e, 0, sizeof(e));
+    e.type = DELIVER;
+    e.node = v;
+    e.time = now + latency[current * (motes_count + 1) + v] * 1000ULL;
+    e.channel = channel;
+    e.from = current;
+    e.unicast = unicast;
+    e.length = length;
+    e.data = malloc(length);
+    memcpy(e.data, data, length);
+
+    push(&e);
+  }
+}
+
+// =============================================================================================================
+
+static void handle_line(int node, const char *line)
+{
+
+  const char *w;
+
+  if (verbose)
+    fprintf(stderr, "%10.3f %3d %s\n", now / 1e6, node, line);
+
+  if (node == DEVICE_D && strncmp(line, "Finished -> ", 12) == 0 && (w = strstr(line, "W -> ")) != NULL)
+  {
+    found_cost = strtoul(w + 5, NULL, 10);
+    found_latency = (w = strstr(line, "L -> ")) != NULL ? atoi(w + 5) : -1;
+    finished_at = now;
+    solved = 1;
+
+    snprintf(found_route, sizeof(found_route), "%s", line + strlen("Finished -> route -> "));
+  }
+
+  if (node == DEVICE_D && strncmp(line, "Route ", 6) == 0 && reaction != NULL)
+  {
+    if (strncmp(line, "Route kept", 10) == 0 && (w = strstr(line, "W -> ")) != NULL)
+    {
+      found_cost = strtoul(w + 5, NULL, 10);
+      found_latency = (w = strstr(line, "L -> ")) != NULL ? atoi(w + 5) : -1;
+      reaction = "kept";
+    }
+    else if (strncmp(line, "Route switched", 14) == 0)
+      reaction = "switched";
+    else if (strncmp(line, "Route lost", 10) == 0)
+    {
+      found_cost = ROUTE_COST_MAX;
+      found_latency = -1;
+      reaction = "lost";
+    }
+  }
+
+  if (strncmp(line, "Messages -> ", 12) == 0)
+    messages += atoi(line + 12);
+}
+
+int sim_printf(const char *format, ...)
+{
+
+  struct mote *m = &motes[current];
+  char buffer[512], *c;
+  va_list args;
+  int n;
+
+  va_start(args, format);
+  n = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+
+  for (c = buffer; *c; c++)
+  {
+    if (*c == '\n')
+    {
+      m->line[m->line_length] = '\0';
+
+      if (m->line_length > 0)
+        handle_line(current, m->line);
+
+      m->line_length = 0;
+    }
+    else if (m->line_length < (int)sizeof(m->line) - 1)
+      m->line[m->line_length++] = *c;
+  }
+
+  return n;
+}
+
+// =============================================================================================================
+
+static void post_serial(int node, uint64_t time, const char *line)
+{
+
+  struct event e;
+
+  memset(&e, 0, sizeof(e));
+  e.type = SERIAL;
+  e.node = node;
+  e.time = time;
+  e.data = strdup(line);
+  push(&e);
+}
+
+static void dispatch(struct event *e)
+{
+
+  now = e->time;
+  current = e->node;
+  load(current);
+
+  switch (e->type)
+  {
+  case WAKE:
+    if (motes[current].wake <= now)
+      motes[current].wake = NODE_IDLE;
+
+    run();
+    break;
+
+  case DELIVER:
+    if (e->time < motes[current].busy_until)
+      collisions++;
+
+    if (e->time + (e->length + FRAME_OVERHEAD) * AIRTIME_PER_BYTE > motes[current].busy_until)
+      motes[current].busy_until = e->time + (e->length + FRAME_OVERHEAD) * AIRTIME_PER_BYTE;
+
+    receive(e->channel, e->unicast, e->from, e->data, e->length);
+    break;
+
+  case SERIAL:
+    serial(e->data);
+    break;
+  }
+
+  free(e->data);
+  schedule_wake(current);
+}
+
+// =============================================================================================================
+
+// regioes PT_LOAD gravaveis do firmware-sim.so: .data, .bss e as tabelas do carregador
+
+static int find_segments(struct dl_phdr_info *info, size_t size, void *data)
+{
+
+  int i;
+
+  if (info->dlpi_addr != library_base)
+    return 0;
+
+  for (i = 0; i < info->dlpi_phnum && segment_count < MAX_SEGMENTS; i++)
+  {
+    const ElfW(Phdr) *ph = &info->dlpi_phdr[i];
+
+    if (ph->p_type == PT_LOAD && (ph->p_flags & PF_W))
+    {
+      segments[segment_count].start = (uint8_t *)(info->dlpi_addr + ph->p_vaddr);
+      segments[segment_count].size = ph->p_memsz;
+      memory_size += ph->p_memsz;
+      segment_count++;
+    }
+  }
+
+  return 1;
+}
+
+static void open_firmware(void)
+{
+
+  struct link_map *map;
+  size_t offset;
+  void *library;
+  int i;
+
+  library = dlopen(firmware, RTLD_NOW | RTLD_LOCAL);
+
+  if (library == NULL)
+  {
+    fprintf(stderr, "route-sim: %s\n", dlerror());
+    exit(1);
+  }
+
+  boot = (void (*)(uint16_t, unsigned short))dlsym(library, "node_boot");
+  run = (void (*)(void))dlsym(library, "node_run");
+  receive = (void (*)(uint16_t, int, uint16_t, const void *, int))dlsym(library, "node_receive");
+  serial = (void (*)(const char *))dlsym(library, "node_serial");
+  next_timer = (uint64_t(*)(void))dlsym(library, "node_next_timer");
+
+  if (boot == NULL || run == NULL || receive == NULL || serial == NULL || next_timer == NULL ||
+      dlinfo(library, RTLD_DI_LINKMAP, &map) != 0)
+  {
+    fprintf(stderr, "route-sim: %s nao e um firmware do simulador\n", firmware);
+    exit(1);
+  }
+
+  library_base = map->l_addr;
+  dl_iterate_phdr(find_segments, NULL);
+
+  if (segment_count == 0)
+  {
+    fprintf(stderr, "route-sim: segmento gravavel de %s nao encontrado\n", firmware);
+    exit(1);
+  }
+
+  // copia de antes de qualquer boot: o estado inicial de todo no
+  initial_memory = malloc(memory_size);
+
+  for (i = 0, offset = 0; i < segment_count; offset += segments[i++].size)
+    memcpy(initial_memory + offset, segments[i].start, segments[i].size);
+}
+
+// =============================================================================================================
+
+// grafo geometrico aleatorio com densidade media de vizinhos e latencias uniformes em 1..max_latency
+
+static void generate_topology(void)
+{
+
+  double x[MAXIMUM_DEVICES + 1], y[MAXIMUM_DEVICES + 1];
+  double side = sqrt(motes_count * M_PI / density);
+  int u, v;
+
+  memset(latency, 0, (motes_count + 1) * (motes_count + 1));
+
+  for (u = 1; u <= motes_count; u++)
+  {
+    x[u] = side * next_random() / 2147483648.0;
+    y[u] = side * next_random() / 2147483648.0;
+  }
+
+  for (u = 1; u <= motes_count; u++)
+  {
+    for (v = u + 1; v <= motes_count; v++)
+    {
+      if ((x[u] - x[v]) * (x[u] - x[v]) + (y[u] - y[v]) * (y[u] - y[v]) <= 1.0)
+      {
+        latency[u * (motes_count + 1) + v] = latency[v * (motes_count + 1) + u] = 1 + next_random() % max_latency;
+      }
+    }
+  }
+}
+
+// =============================================================================================================
+
+// referencia centralizada: menor latencia de DEVICE_D a cada vertice e a alocacao de menor (route_cost,
+// latencia) entre os que cabem no requisito; ROUTE_COST_MAX se nenhum cabe. o desempate pela latencia importa:
+// preco 0 zera o route_cost, e sem ele qualquer no gratuito dentro do requisito empataria como otimo
+
+static route_cost_t dijkstra_reference(int *best_latency)
+{
+
+  int distance[MAXIMUM_DEVICES + 1], done[MAXIMUM_DEVICES + 1];
+  route_cost_t best = ROUTE_COST_MAX, cost;
+  int u, v, i;
+
+  *best_latency = -1;
+
+  for (v = 1; v <= motes_count; v++)
+  {
+    distance[v] = -1;
+    done[v] = 0;
+  }
+
+  distance[DEVICE_D] = 0;
+
+  for (i = 0; i < motes_count; i++)
+  {
+    u = 0;
+
+    for (v = 1; v <= motes_count; v++)
+      if (!done[v] && distance[v] >= 0 && (u == 0 || distance[v] < distance[u]))
+        u = v;
+
+    if (u == 0)
+      break;
+
+    done[u] = 1;
+
+    for (v = 1; v <= motes_count; v++)
+    {
+      int l = latency[u * (motes_count + 1) + v];
+
+      if (l && (distance[v] < 0 || distance[u] + l < distance[v]))
+        distance[v] = distance[u] + l;
+    }
+  }
+
+  for (v = 1; v <= motes_count; v++)
+  {
+    if (v == DEVICE_D || distance[v] < 0 || distance[v] > LATENCY_REQUIREMENT)
+      continue;
+
+    cost = route_cost(distance[v], motes[v].price, motes[v].resource);
+
+    if (cost < best || (cost == best && distance[v] < *best_latency))
+    {
+      best = cost;
+      *best_latency = distance[v];
+    }
+  }
+
+  return best;
+}
+
+// =============================================================================================================
+
+// processa os eventos ate end; com settle, para tambem quando a solucao fica settle segundos sem mudar
+
+static void run_until(uint64_t end, int until_settled)
+{
+
+  while (heap_length > 0 && heap[0].time <= end)
+  {
+    // o Bellman-Ford pode melhorar a solucao depois do primeiro Finished: vale a ultima ate o silencio
+    if (until_settled && solved && heap[0].time > finished_at + settle * 1000000)
+      break;
+
+    struct event e = pop();
+    dispatch(&e);
+  }
+}
+
+// "S" em cada no, como o benchmark.js: soma das mensagens enviadas ate agora
+
+static int count_messages(void)
+{
+
+  int v;
+
+  messages = 0;
+
+  for (v = 1; v <= motes_count; v++)
+  {
+    current = v;
+    load(v);
+    serial("S");
+    schedule_wake(v);
+  }
+
+  return messages;
+}
+
+// ultimo enlace da rota "1-4-7-" de found_route fica slowdown vezes mais lento
+
+static void slow_down_route(void)
+{
+
+  int u = 0, v = 0, hop;
+  char *c = found_route;
+  int l;
+
+  while (*c >= '0' && *c <= '9')
+  {
+    hop = strtol(c, &c, 10);
+    u = v;
+    v = hop;
+
+    if (*c == '-')
+      c++;
+  }
+
+  if (u < 1 || v < 1 || u > motes_count || v > motes_count)
+    return;
+
+  l = latency[u * (motes_count + 1) + v] * slowdown;
+  l = l > 255 ? 255 : l;
+
+  latency[u * (motes_count + 1) + v] = latency[v * (motes_count + 1) + u] = l;
+}
+
+// =============================================================================================================
+
+static void simulate(int topology)
+{
+
+  const struct profile *profile;
+  struct event e;
+  route_cost_t optimal;
+  char line[64];
+  int v, before = 0, optimal_latency;
+
+  random_state = base_seed * 1000003UL + topology;
+
+  generate_topology();
+
+  heap_length = 0;
+  now = 0;
+  loaded = -1;
+  solved = 0;
+  messages = 0;
+  collisions = 0;
+  found_cost = ROUTE_COST_MAX;
+  found_latency = -1;
+  found_route[0] = '\0';
+  reaction = NULL;
+
+  for (v = 1; v <= motes_count; v++)
+  {
+    memcpy(motes[v].memory, initial_memory, memory_size);
+    motes[v].wake = NODE_IDLE;
+    motes[v].busy_until = 0;
+    motes[v].line_length = 0;
+
+    profile = &profiles[next_random() % (sizeof(profiles) / sizeof(profiles[0]))];
+    motes[v].price = v == DEVICE_D ? 0 : profile->price;
+    motes[v].resource = v == DEVICE_D ? 0 : profile->resource;
+
+    current = v;
+    load(v);
+    boot(v, next_random());
+    schedule_wake(v);
+
+    // a descoberta comeca depois do aquecimento, quando as sondas ja mediram os enlaces
+    if (v == DEVICE_D)
+      snprintf(line, sizeof(line), "DT%dQ0C0R", motes_count);
+    else
+      snprintf(line, sizeof(line), "%sT%dQ%dC%dR", profile->kind, motes_count, profile->price, profile->resource);
+
+    post_serial(v, warmup * 1000000, line);
+  }
+
+  run_until((warmup + limit) * 1000000, 1);
+
+  if (slowdown && solved)
+  {
+    before = count_messages();
+    reaction = "none";
+
+    now = heap_length > 0 ? heap[0].time : now;
+    slow_down_route();
+    run_until(now + REACTION_WINDOW * 1000000ULL, 0);
+  }
+
+  while (heap_length > 0)
+  {
+    e = pop();
+    free(e.data);
+  }
+
+  messages = count_messages();
+  optimal = dijkstra_reference(&optimal_latency);
+
+  printf("%s,%d,%d,%lu,%ld,%d,", label, topology, motes_count, base_seed,
+         solved ? (long)((finished_at - warmup * 1000000) / 1000) : -1L, messages);
+
+  if (found_cost != ROUTE_COST_MAX)
+    printf("%lu,%d,", found_cost, found_latency);
+  else
+    printf(",,");
+
+  if (optimal != ROUTE_COST_MAX)
+    printf("%lu,%d,", (unsigned long)optimal, optimal_latency);
+  else
+    printf(",,");
+
+  // 1 quando a alocacao encontrada e a otima (ou quando nao havia nenhuma dentro do requisito); com o mesmo
+  // custo, a razao das latencias
+  if (found_cost == optimal && (optimal == ROUTE_COST_MAX || found_latency == optimal_latency))
+    printf("1.0000,");
+  else if (found_cost == ROUTE_COST_MAX || optimal == ROUTE_COST_MAX)
+    printf("0.0000,");
+  else if (found_cost == optimal)
+    printf("%.4f,", (double)optimal_latency / found_latency);
+  else
+    printf("%.4f,", (double)optimal / found_cost);
+
+  // mensagens depois da mudanca no enlace, contra a descoberta inteira de antes
+  if (reaction != NULL)
+    printf("%s,%d,", reaction, messages - before);
+  else
+    printf(",,");
+
+  printf("%d\n", collisions);
+
+  fflush(stdout);
+}
+
+// =============================================================================================================
+
+static void usage(void)
+{
+  fprintf(stderr, "uso: route-sim [-n motes] [-t topologias] [-j processos] [-s semente] [-d vizinhos]\n"
+                  "                [-l latencia_max_ms] [-T limite_s] [-S silencio_s] [-W aquecimento_s]\n"
+                  "                [-x fator] [-L rotulo] [-f firmware-sim.so] [-v]\n");
+  exit(1);
+}
+
+int main(int argc, char **argv)
+{
+
+  int option, worker, topology, v;
+
+  workers = sysconf(_SC_NPROCESSORS_ONLN);
+
+  while ((option = getopt(argc, argv, "n:t:j:s:d:l:T:S:W:x:L:f:v")) != -1)
+  {
+    switch (option)
+    {
+    case 'n': motes_count = atoi(optarg); break;
+    case 't': topologies = atoi(optarg); break;
+    case 'j': workers = atoi(optarg); break;
+    case 's': base_seed = strtoul(optarg, NULL, 10); break;
+    case 'd': density = atoi(optarg); break;
+    case 'l': max_latency = atoi(optarg); break;
+    case 'T': limit = strtoull(optarg, NULL, 10); break;
+    case 'S': settle = strtoull(optarg, NULL, 10); break;
+    case 'W': warmup = strtoull(optarg, NULL, 10); break;
+    case 'x': slowdown = atoi(optarg); break;
+    case 'L': label = optarg; break;
+    case 'f': firmware = optarg; break;
+    case 'v': verbose = 1; break;
+    default: usage();
+    }
+  }
+
+  if (motes_count < 2 || motes_count > MAXIMUM_DEVICES || topologies < 1 || density < 1 || max_latency < 1 ||
+      max_latency > 255 || slowdown < 0)
+    usage();
+
+  if (workers < 1)
+    workers = 1;
+
+  if (workers > topologies)
+    workers = topologies;
+
+  open_firmware();
+
+  motes = calloc(motes_count + 1, sizeof(struct mote));
+  latency = malloc((motes_count + 1) * (motes_count + 1));
+
+  for (v = 1; v <= motes_count; v++)
+    motes[v].memory = malloc(memory_size);
+
+  printf("label,topology,motes,seed,time_to_solution_ms,messages,cost,latency,optimal_cost,optimal_latency,optimality,"
+         "reaction,update_messages,collisions\n");
+  fflush(stdout);
+
+  // cada processo filho roda as topologias de indice congruente ao seu numero; linhas curtas no stdout
+  // compartilhado chegam inteiras
+  for (worker = 0; worker < workers; worker++)
+  {
+    if (workers > 1 && fork() != 0)
+      continue;
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    for (topology = worker; topology < topologies; topology += workers)
+      simulate(topology);
+
+    if (workers > 1)
+      _exit(0);
+
+    return 0;
+  }
+
+  while (wait(NULL) > 0)
+    ;
+
+  return 0;
+}
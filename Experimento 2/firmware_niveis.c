@@ -3,112 +3,561 @@
 #include "net/rime/rime.h"
 #include "dev/serial-line.h"
 
+#include "hop-cost.h"
+
 #include <stdio.h>
+#include <string.h>
 
 #define LIMITE_FRONTEIRA_SINAL -80
 #define LATENCIA_PARAM          150
 
-enum { INICIO, FINALIZADO, PRONTO };
+// custo de cada nivel (hop-cost): tabela do custo acumulado ou linear, ex.: -DMODELO_CUSTO=HOP_COST_LINEAR. O
+// gradiente para no ultimo nivel cujo custo acumulado cabe em LATENCIA_PARAM
+#ifndef MODELO_CUSTO
+#define MODELO_CUSTO HOP_COST_TABLE
+#endif
+
+#define CUSTO_LINEAR_BASE       10
+#define CUSTO_LINEAR_INCLINACAO 40
+
+#if MODELO_CUSTO == HOP_COST_MEASURED
+#error "firmware_niveis nao mede a latencia dos enlaces: use HOP_COST_TABLE ou HOP_COST_LINEAR"
+#endif
+
+// sinal suavizado por vizinho: peso 1 / 2^SINAL_EWMA_SHIFT por amostra e uma faixa de HISTERESE_SINAL dB em
+// volta do limite, para que uma amostra ruidosa nao mude a fronteira
+#define SINAL_EWMA_SHIFT 2
+#define HISTERESE_SINAL  3
+#define MAX_VIZINHOS     16
+
+// sorvedouros (u8[0] dos nos que originam niveis), ex.: -DSORVEDOUROS=1,7,12
+#ifndef SORVEDOUROS
+#define SORVEDOUROS 1
+#endif
+
+#define MAX_SORVEDOUROS 4
+
+// cada sorvedouro reinicia o seu gradiente a cada PERIODO_BEACON com uma sequencia nova: niveis de enlaces que
+// sumiram somem na sequencia seguinte. Um gradiente sem sequencia nova por VALIDADE_GRADIENTE expira: o no
+// deixa de ter nivel para aquele sorvedouro e de enviar agregados ao pai antigo
+#define PERIODO_BEACON  (CLOCK_SECOND * 60)
+#define VALIDADE_GRADIENTE (PERIODO_BEACON * 2)
+#define ATRASO_REENVIO  (CLOCK_SECOND / 2)
+
+#define NIVEL_INFINITO  255
+
+// convergecast: a epoca comeca com o beacon do sorvedouro; o no de nivel n envia o agregado da sua subarvore
+// (NIVEL_MAXIMO_CONVERGECAST - n) slots depois, de modo que os filhos chegam antes
+#define SLOT_CONVERGECAST         (CLOCK_SECOND * 3)
+#define NIVEL_MAXIMO_CONVERGECAST 8
 
 struct broadcast_message {
-  uint8_t interacao;
+  uint8_t sorvedouro;
+  uint8_t sequencia;
+  uint8_t interacao; // nivel de quem recebe pela fronteira
+  uint16_t custo;    // custo acumulado do nivel de quem envia
+};
+
+// menor nivel conhecido ate um sorvedouro e o vizinho que o deu
+struct gradiente {
+  uint8_t sorvedouro; // 0: posicao livre
+  uint8_t sequencia;
+  uint8_t nivel;
+  uint8_t pai;
+  uint8_t pendente;   // nivel novo ainda nao repassado
+  uint8_t celula;     // nivel veio de enlace forte: o pai tem o mesmo nivel
+  uint16_t custo;
+  clock_time_t atualizado; // chegada da sequencia atual
+};
+
+// leituras da subarvore numa epoca
+struct agregado {
+  uint8_t sorvedouro;
+  uint8_t epoca;
+  uint16_t minimo;
+  uint16_t maximo;
+  uint16_t contagem;
+  uint32_t soma;
+};
+
+struct vizinho {
+  uint8_t id;        // 0: posicao livre
+  uint8_t amostras;
+  uint8_t fronteira;
+  int16_t sinal;     // dBm << SINAL_EWMA_SHIFT
 };
 
 static struct broadcast_conn broadcast;
+static struct unicast_conn unicast;
+
+static struct vizinho vizinhos[MAX_VIZINHOS];
+
+static const uint8_t sorvedouros[] = {SORVEDOUROS};
 
-static int status = INICIO;
-static uint8_t interacao_atual = 0;
+static struct gradiente gradientes[MAX_SORVEDOUROS];
+static uint8_t sequencia_propria;
+
+static const int latencia[] = {0, 10, 50, 100, 150, 200, 250, 300, 350, 400};
+
+static const struct hop_cost_model modelo_custo = {
+  MODELO_CUSTO, latencia, sizeof(latencia) / sizeof(latencia[0]), CUSTO_LINEAR_BASE, CUSTO_LINEAR_INCLINACAO, NULL
+};
 
-static const int latencia[10] = {0, 10, 50, 100, 150, 200, 250, 300, 350, 400};
+static struct agregado agregado;   // epoca em curso
+static uint8_t agregado_enviado;
+static uint8_t epoca_nova;         // pede ao convergecast_process para (re)agendar o envio
+static clock_time_t atraso_epoca;
 
 PROCESS(broadcast_process, "Broadcast process");
-AUTOSTART_PROCESSES(&broadcast_process);
+PROCESS(convergecast_process, "Convergecast process");
+AUTOSTART_PROCESSES(&broadcast_process, &convergecast_process);
 
 
 // ========================================================================================
-// Função de broadcast
+// Gradientes
 // ========================================================================================
 
-static void broadcast_recv(struct broadcast_conn *c, const linkaddr_t *from) {
-  
-  uint16_t nivel_sinal = packetbuf_attr(PACKETBUF_ATTR_RSSI);
+static int eh_sorvedouro(void) {
+
+  int i;
+
+  for(i = 0; i < sizeof(sorvedouros) / sizeof(sorvedouros[0]); i++) {
+    if(sorvedouros[i] == linkaddr_node_addr.u8[0]) {
+      return 1;
+    }
+  }
 
-   if(nivel_sinal > LIMITE_FRONTEIRA_SINAL){
-    status = FINALIZADO;
-  
+  return 0;
+}
+
+static struct gradiente *busca_gradiente(uint8_t sorvedouro) {
+
+  int i;
+  struct gradiente *livre = NULL;
+
+  for(i = 0; i < MAX_SORVEDOUROS; i++) {
+
+    if(gradientes[i].sorvedouro == sorvedouro) {
+      return &gradientes[i];
+    }
+
+    if(gradientes[i].sorvedouro == 0 && livre == NULL) {
+      livre = &gradientes[i];
+    }
+  }
+
+  if(livre != NULL) {
+    livre->sorvedouro = sorvedouro;
+    livre->nivel = NIVEL_INFINITO;
+    livre->pendente = 0;
+  }
+
+  return livre;
+}
+
+// gradiente do sorvedouro mais proximo (menor nivel), ou NULL
+static struct gradiente *melhor_gradiente(void) {
+
+  int i;
+  struct gradiente *melhor = NULL;
+
+  for(i = 0; i < MAX_SORVEDOUROS; i++) {
+    if(gradientes[i].sorvedouro != 0 && gradientes[i].nivel != NIVEL_INFINITO &&
+       (melhor == NULL || gradientes[i].nivel < melhor->nivel)) {
+      melhor = &gradientes[i];
+    }
+  }
+
+  return melhor;
+}
+
+// menor nivel entre todos os sorvedouros (NIVEL_INFINITO sem nenhum) e o pai correspondente; um sorvedouro e
+// o proprio pai, no nivel 0
+static uint8_t nivel_atual(uint8_t *pai) {
+
+  struct gradiente *g = melhor_gradiente();
+
+  if(eh_sorvedouro()) {
+
+    if(pai != NULL) {
+      *pai = linkaddr_node_addr.u8[0];
+    }
+
+    return 0;
+  }
+
+  if(g == NULL) {
+    return NIVEL_INFINITO;
+  }
+
+  if(pai != NULL) {
+    *pai = g->pai;
+  }
+
+  return g->nivel;
+}
+
+// vizinho de from; cheia, a tabela reaproveita o vizinho com menos amostras
+static struct vizinho *busca_vizinho(const linkaddr_t *from) {
+
+  int i;
+  struct vizinho *v = &vizinhos[0];
+
+  for(i = 0; i < MAX_VIZINHOS; i++) {
+
+    if(vizinhos[i].id == from->u8[0]) {
+      return &vizinhos[i];
+    }
+
+    if(vizinhos[i].amostras < v->amostras) {
+      v = &vizinhos[i];
+    }
+  }
+
+  v->id = from->u8[0];
+  v->amostras = 0;
+
+  return v;
+}
+
+// sinal forte: o no esta dentro da celula de quem enviou e nao e fronteira. A primeira amostra decide pelo
+// limite; as seguintes entram na media e so mudam a decisao fora da faixa de histerese
+static int enlace_fronteira(const linkaddr_t *from) {
+
+  // o RSSI chega num atributo de 16 bits sem sinal: o valor e negativo
+  int16_t nivel_sinal = (int16_t)packetbuf_attr(PACKETBUF_ATTR_RSSI);
+  struct vizinho *v = busca_vizinho(from);
+  int media;
+
+  if(v->amostras == 0) {
+    v->sinal = nivel_sinal * (1 << SINAL_EWMA_SHIFT);
+    v->fronteira = nivel_sinal <= LIMITE_FRONTEIRA_SINAL;
   } else {
-    
-    if(status == INICIO) {
-       
-       struct broadcast_message *m;
-       m = packetbuf_dataptr();      
-       interacao_atual = m->interacao;
+    v->sinal += nivel_sinal - v->sinal / (1 << SINAL_EWMA_SHIFT);
+  }
+
+  if(v->amostras < 255) {
+    v->amostras++;
+  }
 
-       printf("Recebei broadcast de %d sinal -> %d interacao -> %d\n", from->u8[0], nivel_sinal, m->interacao);
+  media = v->sinal / (1 << SINAL_EWMA_SHIFT);
 
-       status = PRONTO;
+  if(v->fronteira && media > LIMITE_FRONTEIRA_SINAL + HISTERESE_SINAL) {
+    v->fronteira = 0;
+  } else if(!v->fronteira && media < LIMITE_FRONTEIRA_SINAL - HISTERESE_SINAL) {
+    v->fronteira = 1;
+  }
+
+  printf("Sinal de %d -> %d media -> %d fronteira -> %d\n", from->u8[0], nivel_sinal, media, v->fronteira);
+
+  return v->fronteira;
+}
+
+
+// ========================================================================================
+// Convergecast
+// ========================================================================================
+
+// leitura de exemplo (a plataforma nao tem sensor neste experimento)
+static uint16_t leitura(void) {
+  return 200 + random_rand() % 100;
+}
+
+static void junta_agregado(struct agregado *a, const struct agregado *b) {
+
+  if(b->minimo < a->minimo) {
+    a->minimo = b->minimo;
+  }
+
+  if(b->maximo > a->maximo) {
+    a->maximo = b->maximo;
+  }
+
+  a->soma += b->soma;
+  a->contagem += b->contagem;
+}
+
+// epoca nova do sorvedouro: recomeca o agregado com a leitura propria. Na mesma epoca, um nivel melhor so
+// muda o instante do envio
+static void inicia_epoca(uint8_t sorvedouro, uint8_t epoca, uint8_t nivel, int celula) {
+
+  if(agregado.sorvedouro != sorvedouro || agregado.epoca != epoca) {
+    agregado.sorvedouro = sorvedouro;
+    agregado.epoca = epoca;
+    agregado.minimo = agregado.maximo = leitura();
+    agregado.soma = agregado.minimo;
+    agregado.contagem = 1;
+    agregado_enviado = 0;
+  }
+
+  if(nivel > NIVEL_MAXIMO_CONVERGECAST) {
+    nivel = NIVEL_MAXIMO_CONVERGECAST;
+  }
+
+  // dentro da celula o pai tem o mesmo nivel: meio slot antes dele
+  atraso_epoca = (NIVEL_MAXIMO_CONVERGECAST - nivel) * SLOT_CONVERGECAST + (celula ? 0 : SLOT_CONVERGECAST / 2);
+
+  epoca_nova = 1;
+  process_poll(&convergecast_process);
+}
 
-       if (LATENCIA_PARAM <= latencia[interacao_atual]) {
-          status = FINALIZADO;
-          printf("Finalizou no %d nivel\n", interacao_atual - 1);
-       }           
+// no sorvedouro, imprime; nos demais, sobe para o pai no gradiente do sorvedouro do agregado
+static void envia_agregado(const struct agregado *a) {
+
+  int i;
+  linkaddr_t pai;
+
+  if(a->sorvedouro == linkaddr_node_addr.u8[0]) {
+    printf("Agregado sorvedouro -> %u epoca -> %u min -> %u max -> %u soma -> %lu contagem -> %u\n",
+           a->sorvedouro, a->epoca, a->minimo, a->maximo, (unsigned long)a->soma, a->contagem);
+    return;
+  }
+
+  for(i = 0; i < MAX_SORVEDOUROS; i++) {
+    if(gradientes[i].sorvedouro == a->sorvedouro && gradientes[i].nivel != NIVEL_INFINITO) {
+      break;
     }
   }
+
+  if(i == MAX_SORVEDOUROS) {
+    return;
+  }
+
+  linkaddr_copy(&pai, &linkaddr_null);
+  pai.u8[0] = gradientes[i].pai;
+
+  packetbuf_copyfrom(a, sizeof(struct agregado));
+  unicast_send(&unicast, &pai);
+}
+
+// agregado de um filho: entra no da epoca em curso; atrasado ou de outra epoca, sobe como chegou
+static void unicast_recv(struct unicast_conn *c, const linkaddr_t *from) {
+
+  static struct agregado recebido;
+
+  if(packetbuf_datalen() != sizeof(struct agregado)) {
+    return;
+  }
+
+  memcpy(&recebido, packetbuf_dataptr(), sizeof(struct agregado));
+
+  if(recebido.sorvedouro == agregado.sorvedouro && recebido.epoca == agregado.epoca && !agregado_enviado) {
+    junta_agregado(&agregado, &recebido);
+    return;
+  }
+
+  envia_agregado(&recebido);
+}
+
+static const struct unicast_callbacks unicast_call = {unicast_recv};
+
+
+// ========================================================================================
+// Função de broadcast
+// ========================================================================================
+
+// a fronteira da celula de quem enviou fica com o nivel da mensagem e repassa o gradiente; dentro da celula,
+// o no fica com o nivel de quem enviou e nao repassa. Vale o menor nivel da sequencia mais nova de cada
+// sorvedouro
+
+static void broadcast_recv(struct broadcast_conn *c, const linkaddr_t *from) {
+
+  struct broadcast_message *m = packetbuf_dataptr();
+  struct gradiente *g;
+  int fronteira, nova, custo, proximo;
+  uint8_t nivel, minimo, pai;
+
+  if(packetbuf_datalen() != sizeof(struct broadcast_message) || m->sorvedouro == linkaddr_node_addr.u8[0]) {
+    return;
+  }
+
+  g = busca_gradiente(m->sorvedouro);
+
+  if(g == NULL) {
+    return;
+  }
+
+  fronteira = enlace_fronteira(from);
+  nivel = fronteira ? m->interacao : m->interacao - 1;
+
+  // dentro da celula o nivel e o de quem enviou, com o mesmo custo; alem do orcamento (ou da tabela) nao ha nivel
+  custo = fronteira ? hop_cost_next(&modelo_custo, m->custo, nivel, from) : m->custo;
+
+  if(custo == HOP_COST_UNKNOWN || custo > LATENCIA_PARAM) {
+    return;
+  }
+
+  nova = g->nivel == NIVEL_INFINITO || (int8_t)(m->sequencia - g->sequencia) > 0;
+
+  if(!nova && (m->sequencia != g->sequencia || nivel >= g->nivel)) {
+    return;
+  }
+
+  printf("Recebei broadcast de %d sorvedouro -> %d interacao -> %d nivel -> %d custo -> %d\n",
+         from->u8[0], m->sorvedouro, m->interacao, nivel, custo);
+
+  if(nova) {
+    g->atualizado = clock_time();
+  }
+
+  g->sequencia = m->sequencia;
+  g->nivel = nivel;
+  g->pai = from->u8[0];
+  g->custo = custo;
+  g->pendente = 0;
+
+  g->celula = !fronteira;
+
+  minimo = nivel_atual(&pai);
+  printf("Nivel atual -> %u pai -> %u\n", minimo, pai);
+
+  // o gradiente do sorvedouro mais proximo marca as epocas do convergecast
+  if(g == melhor_gradiente() && !eh_sorvedouro()) {
+    inicia_epoca(g->sorvedouro, g->sequencia, g->nivel, g->celula);
+  }
+
+  if(!fronteira) {
+    return;
+  }
+
+  proximo = hop_cost_next(&modelo_custo, custo, nivel + 1, NULL);
+
+  if(proximo == HOP_COST_UNKNOWN || proximo > LATENCIA_PARAM) {
+    printf("Finalizou no %d nivel\n", nivel);
+    return;
+  }
+
+  g->pendente = 1;
+  process_poll(&broadcast_process);
 }
 
 static const struct broadcast_callbacks broadcast_call = {broadcast_recv};
 
+// libera os gradientes cujo sorvedouro nao e ouvido ha VALIDADE_GRADIENTE
+static void expira_gradientes(void) {
+
+  int i;
+  uint8_t nivel, pai = 0;
+
+  for(i = 0; i < MAX_SORVEDOUROS; i++) {
+
+    if(gradientes[i].sorvedouro == 0 || (clock_time_t)(clock_time() - gradientes[i].atualizado) <= VALIDADE_GRADIENTE) {
+      continue;
+    }
+
+    printf("Gradiente do sorvedouro %u expirou\n", gradientes[i].sorvedouro);
+
+    gradientes[i].sorvedouro = 0;
+    gradientes[i].nivel = NIVEL_INFINITO;
+    gradientes[i].pendente = 0;
+
+    nivel = nivel_atual(&pai);
+    printf("Nivel atual -> %u pai -> %u\n", nivel, pai);
+  }
+}
+
+static void envia_nivel(uint8_t sorvedouro, uint8_t sequencia, uint8_t nivel, uint16_t custo) {
+
+  struct broadcast_message msg;
+
+  msg.sorvedouro = sorvedouro;
+  msg.sequencia = sequencia;
+  msg.interacao = nivel + 1;
+  msg.custo = custo;
+
+  printf("Interacao atual -> %u sorvedouro -> %u\n", nivel, sorvedouro);
+
+  packetbuf_copyfrom(&msg, sizeof(struct broadcast_message));
+  broadcast_send(&broadcast);
+  printf("Enviou broadcast....\n");
+}
+
 
 // ========================================================================================
-// Theads 
+// Theads
 // ========================================================================================
 
 PROCESS_THREAD(broadcast_process, ev, data) {
-  
-  static struct etimer et;
-  struct broadcast_message msg;
+
+  static struct etimer beacon, reenvio, validade;
+  int i;
 
   PROCESS_EXITHANDLER(broadcast_close(&broadcast));
   PROCESS_BEGIN();
-  
+
   broadcast_open(&broadcast, 129, &broadcast_call);
-  
-  while(1) { 
+  etimer_set(&validade, PERIODO_BEACON / 2);
 
-    etimer_set(&et, status == INICIO ? CLOCK_SECOND * 16 + random_rand() % (CLOCK_SECOND * 16) : CLOCK_SECOND);
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  if(eh_sorvedouro()) {
+    etimer_set(&beacon, CLOCK_SECOND * 16 + random_rand() % (CLOCK_SECOND * 16));
+  }
 
-    switch (status){
+  while(1) {
 
-      case INICIO:
+    PROCESS_WAIT_EVENT();
 
-        if(linkaddr_node_addr.u8[0] == 1) {
+    // sorvedouro: nivel 0 com uma sequencia nova
+    if(ev == PROCESS_EVENT_TIMER && data == &beacon) {
+      envia_nivel(linkaddr_node_addr.u8[0], ++sequencia_propria, 0, 0);
+      inicia_epoca(linkaddr_node_addr.u8[0], sequencia_propria, 0, 0);
+      etimer_set(&beacon, PERIODO_BEACON);
+    }
 
-          printf("Interacao atual -> %u\n", interacao_atual);
-          msg.interacao = interacao_atual + 1;
+    if(ev == PROCESS_EVENT_TIMER && data == &validade) {
+      expira_gradientes();
+      etimer_reset(&validade);
+    }
 
-          packetbuf_copyfrom(&msg, sizeof(struct broadcast_message));
-          broadcast_send(&broadcast);
-          printf("Enviou broadcast....\n");
-          
-          status = FINALIZADO;
+    // niveis novos saem depois de um atraso aleatorio, um por vez, para nao colidir com os dos vizinhos
+    if(ev == PROCESS_EVENT_POLL && etimer_expired(&reenvio)) {
+      etimer_set(&reenvio, ATRASO_REENVIO / 2 + random_rand() % ATRASO_REENVIO);
+    }
+
+    if(ev == PROCESS_EVENT_TIMER && data == &reenvio) {
+
+      for(i = 0; i < MAX_SORVEDOUROS; i++) {
+        if(gradientes[i].pendente) {
+          gradientes[i].pendente = 0;
+          envia_nivel(gradientes[i].sorvedouro, gradientes[i].sequencia, gradientes[i].nivel, gradientes[i].custo);
+          break;
         }
-      break;
+      }
 
-      case PRONTO:
-
-        printf("Interacao atual -> %u\n", interacao_atual);
-        msg.interacao = interacao_atual + 1;
-        
-        packetbuf_copyfrom(&msg, sizeof(struct broadcast_message));
-        broadcast_send(&broadcast);
-        printf("Enviou broadcast....\n");
-        
-        status = FINALIZADO;
-        
-      break;
+      for(i = 0; i < MAX_SORVEDOUROS; i++) {
+        if(gradientes[i].pendente) {
+          etimer_set(&reenvio, ATRASO_REENVIO / 2 + random_rand() % ATRASO_REENVIO);
+          break;
+        }
+      }
     }
   }
 
   PROCESS_END();
-}
\ No newline at end of file
+}
+
+PROCESS_THREAD(convergecast_process, ev, data) {
+
+  static struct etimer envio;
+
+  PROCESS_EXITHANDLER(unicast_close(&unicast));
+  PROCESS_BEGIN();
+
+  unicast_open(&unicast, 146, &unicast_call);
+
+  while(1) {
+
+    PROCESS_WAIT_EVENT();
+
+    if(ev == PROCESS_EVENT_POLL && epoca_nova) {
+      epoca_nova = 0;
+      etimer_set(&envio, atraso_epoca);
+    }
+
+    if(ev == PROCESS_EVENT_TIMER && data == &envio && !agregado_enviado) {
+      agregado_enviado = 1;
+      envia_agregado(&agregado);
+    }
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,156 @@
+importPackage(java.io);
+importPackage(java.util);
+
+// ================================================================================================================
+// BENCHMARK DE COBERTURA E LATENCIA DA REPLICACAO
+// PARAMETROS VIA -D NA LINHA DE COMANDO DO COOJA (VER benchmark.sh)
+// ================================================================================================================
+
+function param(name, value) {
+    var v = java.lang.System.getProperty("bench." + name);
+    return v == null ? value : "" + v;
+}
+
+var SIZE = parseInt(param("size", "0"));          // 0 = TODOS OS MOTES DA SIMULACAO
+var DENSITY = parseFloat(param("density", "0"));  // VIZINHOS MEDIOS POR NO; 0 = MANTEM AS POSICOES DO .csc
+var RANGE = parseFloat(param("range", "50"));     // ALCANCE DE TRANSMISSAO DO UDGM (m)
+var DATASETS = parseInt(param("datasets", "1"));
+var LIMIT = parseInt(param("limit", "1800")) * 1000000;
+var OUTPUT = param("output", "benchmark.csv");
+var LABEL = param("label", "baseline");
+
+var THRESHOLDS = [25, 50, 75, 90, 100];
+
+sim.setSpeedLimit(null);
+
+var seed = sim.getRandomSeed();
+var random = new Random(seed);
+
+// ================================================================================================================
+// TOPOLOGIA: REMOVE OS MOTES EXCEDENTES E DISTRIBUI OS RESTANTES NUM QUADRADO COM A DENSIDADE PEDIDA
+// ================================================================================================================
+
+var motes = sim.getMotes();
+
+if (SIZE > 0) {
+    while (motes.length > SIZE) {
+        sim.removeMote(motes[motes.length - 1]);
+        motes = sim.getMotes();
+    }
+}
+
+if (DENSITY > 0) {
+    var side = Math.sqrt(motes.length * Math.PI * RANGE * RANGE / DENSITY);
+
+    for (var i = 0; i < motes.length; i++) {
+        motes[i].getInterfaces().getPosition().setCoordinates(random.nextDouble() * side, random.nextDouble() * side, 0);
+    }
+}
+
+// ================================================================================================================
+// INICIALIZACAO (IGUAL AO cenario.js)
+// ================================================================================================================
+
+var seeds = [];
+while (seeds.length < Math.min(DATASETS, motes.length)) {
+    var index = random.nextInt(motes.length);
+    if (seeds.indexOf(index) < 0) {
+        seeds.push(index);
+    }
+}
+
+var started = 0;
+while (started < motes.length) {
+    YIELD();
+
+    if (msg.startsWith("Starting")) {
+        started++;
+    }
+}
+
+for (var i = 0; i < motes.length; i++) {
+    write(motes[i], "" + (seeds.indexOf(i) + 1));
+}
+
+// ================================================================================================================
+// COLETA: INSTANTE EM QUE CADA MOTE REPORTA HAS PELA PRIMEIRA VEZ
+// ================================================================================================================
+
+// O STATUS CHEGA PELO LOG BINARIO (event-log.h): "E" + id + lost + time + a + b EM HEX, COM O ESTADO AGREGADO NO
+// BYTE ALTO DE a. EV_STATUS = 1 E HAS_DATA = 5 NO ENUM DO FIRMWARE. SE O REGISTRO DA MUDANCA FOR DESCARTADO COM O
+// BUFFER CHEIO, O FIRMWARE REPETE O STATUS ATUAL NO PROXIMO show_log(): O MOTE CHEGA ATRASADO, MAS NAO SE PERDE
+
+function reportsHas(msg) {
+    return msg.length == 17 && msg.startsWith("E01") && parseInt(msg.substr(9, 2), 16) == 5;
+}
+
+var t0 = time;
+var has = {};
+var covered = 0;
+var reached = {};
+
+while (covered < motes.length && time - t0 < LIMIT) {
+    YIELD();
+
+    if (reportsHas(msg) && !has[id]) {
+        has[id] = true;
+        covered++;
+
+        for (var k = 0; k < THRESHOLDS.length; k++) {
+            if (reached[THRESHOLDS[k]] == null && covered * 100 >= THRESHOLDS[k] * motes.length) {
+                reached[THRESHOLDS[k]] = (time - t0) / 1000;
+            }
+        }
+    }
+}
+
+// ================================================================================================================
+// CONTADORES DE FRAMES DE CADA MOTE
+// ================================================================================================================
+
+for (var i = 0; i < motes.length; i++) {
+    write(motes[i], "S");
+}
+
+var stats = [0, 0, 0, 0, 0];
+var answered = 0;
+
+while (answered < motes.length) {
+    YIELD();
+
+    if (msg.startsWith("STATS")) {
+        var fields = msg.split(" ");
+        for (var k = 0; k < stats.length; k++) {
+            stats[k] += parseInt(fields[k + 1]);
+        }
+        answered++;
+    }
+}
+
+// ================================================================================================================
+// RESULTADO EM CSV (UMA LINHA POR EXECUCAO)
+// ================================================================================================================
+
+var file = new File(OUTPUT);
+var header = !file.exists();
+var writer = new FileWriter(file, true);
+
+if (header) {
+    var columns = "label,size,density,seed,datasets";
+    for (var k = 0; k < THRESHOLDS.length; k++) {
+        columns += ",t" + THRESHOLDS[k] + "_ms";
+    }
+    writer.write(columns + ",coverage,frames,radio_tx,retries,nacks,payload_bytes\n");
+}
+
+var line = LABEL + "," + motes.length + "," + DENSITY + "," + seed + "," + DATASETS;
+for (var k = 0; k < THRESHOLDS.length; k++) {
+    line += "," + (reached[THRESHOLDS[k]] == null ? "" : reached[THRESHOLDS[k]]);
+}
+line += "," + (covered / motes.length) + "," + stats.join(",") + "\n";
+
+writer.write(line);
+writer.close();
+
+log.log(line);
+log.testOK();
@@ -0,0 +1,41 @@
+#!/bin/sh
+# ================================================================================================================
+# EXECUTA O benchmark.js PARA CADA COMBINACAO DE TAMANHO, DENSIDADE E SEMENTE
+#
+# USO: ./benchmark.sh <cooja.jar> <simulacao.csc> [saida.csv]
+#
+# A SIMULACAO DEVE CONTER PELO MENOS max(SIZES) MOTES E O benchmark.js NO SCRIPT EDITOR.
+# VARIAVEIS: SIZES, DENSITIES, SEEDS, DATASETS, LIMIT (s), RANGE (m), LABEL
+# ================================================================================================================
+
+COOJA=$1
+CSC=$2
+OUTPUT=${3:-benchmark.csv}
+
+SIZES=${SIZES:-"10 20 40"}
+DENSITIES=${DENSITIES:-"4 8"}
+SEEDS=${SEEDS:-"1 2 3 4 5"}
+DATASETS=${DATASETS:-1}
+LIMIT=${LIMIT:-1800}
+RANGE=${RANGE:-50}
+LABEL=${LABEL:-baseline}
+
+if [ -z "$COOJA" ] || [ -z "$CSC" ]; then
+  echo "uso: $0 <cooja.jar> <simulacao.csc> [saida.csv]" >&2
+  exit 1
+fi
+
+# O COOJA GRAVA O CSV RELATIVO AO SEU PROPRIO DIRETORIO
+OUTPUT=$(cd "$(dirname "$OUTPUT")" && pwd)/$(basename "$OUTPUT")
+
+for size in $SIZES; do
+  for density in $DENSITIES; do
+    for seed in $SEEDS; do
+      echo "size=$size density=$density seed=$seed"
+      java -Dbench.size="$size" -Dbench.density="$density" -Dbench.range="$RANGE" \
+           -Dbench.datasets="$DATASETS" -Dbench.limit="$LIMIT" \
+           -Dbench.output="$OUTPUT" -Dbench.label="$LABEL" \
+           -jar "$COOJA" -nogui="$CSC" -random-seed="$seed" > /dev/null || exit 1
+    done
+  done
+done
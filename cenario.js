@@ -3,7 +3,16 @@ importPackage(java.io);
 sim.setSpeedLimit(1.0);
 var motes = sim.getMotes();
 
-var index = Math.floor(Math.random() * motes.length);
+// NUMERO DE ITENS DE DADOS SEMEADOS EM MOTES DISTINTOS (IDENTIFICADORES 1..DATASETS)
+var DATASETS = 1;
+
+var seeds = [];
+while (seeds.length < Math.min(DATASETS, motes.length)) {
+    var index = Math.floor(Math.random() * motes.length);
+    if (seeds.indexOf(index) < 0) {
+        seeds.push(index);
+    }
+}
 
 var i = 0;
 while (i < motes.length) {
@@ -16,5 +25,5 @@ while (i < motes.length) {
 }
 
 for (i = 0; i < motes.length; i++) {
-    write(motes[i], (index == i) ? "1" : "0");
-}
\ No newline at end of file
+    write(motes[i], "" + (seeds.indexOf(i) + 1));
+}
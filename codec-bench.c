@@ -0,0 +1,111 @@
+// ================================================================================================================
+// BENCHMARK DO CODEC DE REPLICACAO NO HOST
+//
+// gcc -O2 -o codec-bench codec-bench.c replication-codec.c && ./codec-bench [versoes]
+//
+// SIMULA O LOG CIRCULAR DE AMOSTRAS DE UM ITEM (MESMO FORMATO DO FIRMWARE) E MEDE, PARA CADA CODEC, A
+// RAZAO DE COMPRESSAO E O TEMPO DE CPU POR KB DE PAYLOAD CODIFICADO/DECODIFICADO.
+// ================================================================================================================
+
+#include "replication-codec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ITEM_PAYLOAD_SIZE 48
+#define SAMPLES (ITEM_PAYLOAD_SIZE / sizeof(int16_t))
+
+struct result
+{
+  const char *name;
+  long raw_bytes, coded_bytes;
+  double encode_s, decode_s;
+};
+
+static void report(struct result *r)
+{
+  double kb = r->raw_bytes / 1024.0;
+
+  printf("%-10s ratio %5.3f  encode %8.2f us/KB  decode %8.2f us/KB\n",
+         r->name, (double)r->coded_bytes / r->raw_bytes,
+         r->encode_s * 1e6 / kb, r->decode_s * 1e6 / kb);
+}
+
+int main(int argc, char *argv[])
+{
+  int versions = argc > 1 ? atoi(argv[1]) : 100000;
+  uint8_t payload[ITEM_PAYLOAD_SIZE], base[ITEM_PAYLOAD_SIZE], out[ITEM_PAYLOAD_SIZE], check[ITEM_PAYLOAD_SIZE];
+  int16_t *log = (int16_t *)payload;
+  struct result lz = {"lz", 0, 0, 0, 0}, delta = {"delta+lz", 0, 0, 0, 0}, best = {"encode", 0, 0, 0, 0};
+  int v, i, n, length, codec;
+  clock_t t;
+
+  srand(1);
+
+  for (i = 0; i < (int)SAMPLES; i++)
+  {
+    log[i] = 500 + rand() % 64;
+  }
+
+  for (v = 1; v <= versions; v++)
+  {
+    memcpy(base, payload, ITEM_PAYLOAD_SIZE);
+    log[v % SAMPLES] = log[(v - 1) % SAMPLES] + rand() % 8 - 4;
+
+    // SOMENTE LZ
+    t = clock();
+    n = codec_compress(out, ITEM_PAYLOAD_SIZE, payload, ITEM_PAYLOAD_SIZE);
+    lz.encode_s += (double)(clock() - t) / CLOCKS_PER_SEC;
+    lz.raw_bytes += ITEM_PAYLOAD_SIZE;
+    lz.coded_bytes += n < 0 ? ITEM_PAYLOAD_SIZE : n;
+
+    if (n >= 0)
+    {
+      t = clock();
+      codec_decompress(check, ITEM_PAYLOAD_SIZE, out, n);
+      lz.decode_s += (double)(clock() - t) / CLOCKS_PER_SEC;
+    }
+
+    // DELTA CONTRA A VERSAO ANTERIOR + LZ
+    t = clock();
+    codec_xor(check, payload, base, ITEM_PAYLOAD_SIZE);
+    n = codec_compress(out, ITEM_PAYLOAD_SIZE, check, ITEM_PAYLOAD_SIZE);
+    delta.encode_s += (double)(clock() - t) / CLOCKS_PER_SEC;
+    delta.raw_bytes += ITEM_PAYLOAD_SIZE;
+    delta.coded_bytes += n < 0 ? ITEM_PAYLOAD_SIZE : n;
+
+    if (n >= 0)
+    {
+      t = clock();
+      codec_decompress(check, ITEM_PAYLOAD_SIZE, out, n);
+      codec_xor(check, check, base, ITEM_PAYLOAD_SIZE);
+      delta.decode_s += (double)(clock() - t) / CLOCKS_PER_SEC;
+    }
+
+    // ESCOLHA AUTOMATICA (O QUE O FIRMWARE ENVIA) COM VERIFICACAO DE IDA E VOLTA
+    t = clock();
+    codec = codec_encode(out, ITEM_PAYLOAD_SIZE, &length, payload, base, ITEM_PAYLOAD_SIZE);
+    best.encode_s += (double)(clock() - t) / CLOCKS_PER_SEC;
+    best.raw_bytes += ITEM_PAYLOAD_SIZE;
+    best.coded_bytes += length;
+
+    t = clock();
+    n = codec_decode(check, ITEM_PAYLOAD_SIZE, codec, out, length, base);
+    best.decode_s += (double)(clock() - t) / CLOCKS_PER_SEC;
+
+    if (n != ITEM_PAYLOAD_SIZE || memcmp(check, payload, ITEM_PAYLOAD_SIZE))
+    {
+      printf("ERRO: versao %d nao reconstruida (codec %d)\n", v, codec);
+      return 1;
+    }
+  }
+
+  printf("%d versoes de %d bytes\n", versions, ITEM_PAYLOAD_SIZE);
+  report(&lz);
+  report(&delta);
+  report(&best);
+
+  return 0;
+}
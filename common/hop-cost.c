@@ -0,0 +1,60 @@
+#include "hop-cost.h"
+
+// =============================================================================================================
+
+int hop_cost_step(const struct hop_cost_model *model, uint8_t hop, const linkaddr_t *neighbor)
+{
+
+  int cost;
+
+  switch (model->kind)
+  {
+
+  case HOP_COST_TABLE:
+
+    if (hop == 0 || hop >= model->length)
+      return HOP_COST_UNKNOWN;
+
+    cost = model->table[hop] - model->table[hop - 1];
+    break;
+
+  case HOP_COST_LINEAR:
+
+    if (hop == 0)
+      return HOP_COST_UNKNOWN;
+
+    cost = model->base + model->slope * (hop - 1);
+    break;
+
+  case HOP_COST_MEASURED:
+
+    if (model->measure == NULL || neighbor == NULL)
+      return HOP_COST_UNKNOWN;
+
+    cost = model->measure(neighbor);
+    break;
+
+  default:
+    return HOP_COST_UNKNOWN;
+  }
+
+  return cost < 0 || cost > HOP_COST_MAX ? HOP_COST_UNKNOWN : cost;
+}
+
+// =============================================================================================================
+
+int hop_cost_next(const struct hop_cost_model *model, int accumulated, uint8_t hop, const linkaddr_t *neighbor)
+{
+
+  int step;
+
+  if (accumulated < 0)
+    return HOP_COST_UNKNOWN;
+
+  step = hop_cost_step(model, hop, neighbor);
+
+  if (step == HOP_COST_UNKNOWN || step > HOP_COST_MAX - accumulated)
+    return HOP_COST_UNKNOWN;
+
+  return accumulated + step;
+}
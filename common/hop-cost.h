@@ -0,0 +1,45 @@
+#ifndef HOP_COST_H
+#define HOP_COST_H
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+
+#include <stdint.h>
+
+// =============================================================================================================
+// modelo de custo por salto (ms), comum a descoberta de rotas (Experimento 1) e aos niveis (Experimento 2):
+//
+//   HOP_COST_TABLE     tabela do custo acumulado por salto (table[0] = 0); alem da tabela o custo e desconhecido
+//   HOP_COST_LINEAR    o salto h custa base + slope * (h - 1)
+//   HOP_COST_MEASURED  o custo do enlace ate o vizinho vem de measure()
+//
+// todo acumulado passa por hop_cost_next, que recusa saltos desconhecidos e estouro de HOP_COST_MAX
+// =============================================================================================================
+
+#define HOP_COST_UNKNOWN -1
+#define HOP_COST_MAX 0x7fff
+
+// macros, e nao enum, para que os firmwares escolham o modelo com #if
+#define HOP_COST_TABLE 0
+#define HOP_COST_LINEAR 1
+#define HOP_COST_MEASURED 2
+
+struct hop_cost_model
+{
+  uint8_t kind;
+
+  const int *table;
+  uint8_t length;
+
+  int base, slope;
+
+  int (*measure)(const linkaddr_t *neighbor);
+};
+
+// custo do salto hop (1: o primeiro, a partir da origem) pelo enlace ate neighbor, ou HOP_COST_UNKNOWN
+int hop_cost_step(const struct hop_cost_model *model, uint8_t hop, const linkaddr_t *neighbor);
+
+// accumulated mais o salto hop, ou HOP_COST_UNKNOWN se o salto e desconhecido ou o total passa de HOP_COST_MAX
+int hop_cost_next(const struct hop_cost_model *model, int accumulated, uint8_t hop, const linkaddr_t *neighbor);
+
+#endif
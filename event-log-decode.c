@@ -0,0 +1,165 @@
+// ================================================================================================================
+// DECODIFICADOR DO LOG BINARIO DE EVENTOS NO HOST
+//
+// gcc -O2 -o event-log-decode event-log-decode.c && ./event-log-decode [clock_second] < COOJA.testlog
+//
+// LE A SAIDA SERIAL (OU O LOG DO COOJA) E TROCA CADA REGISTRO "E<16 DIGITOS HEX>" PELO TEXTO DO EVENTO,
+// MANTENDO O QUE VEM ANTES DELE NA LINHA (INSTANTE E MOTE DO COOJA). AS DEMAIS LINHAS PASSAM SEM MUDANCA.
+// CLOCK_SECOND DO SKY E 128, O PADRAO.
+// ================================================================================================================
+
+#include "event-log.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_SIZE 512
+
+// MESMA ORDEM DO ENUM DE TIPOS DE firmware-replicacao.v2.c
+
+static const char *names[] = {
+    "LL", "LLN", "FLL",
+    "RUN", "BEGIN", "HAS", "WAITING",
+    "SENDING_DATA", "CONFIRM_DATA_OK", "SENDING_STATUS", "GET_STATUS", "NACK_DATA",
+    "QUERY_DATA", "QUERY_REPLY", "SENDING_SUMMARY",
+    "NACK_BASE", "SUMMARY_ACK"};
+
+static const char *name(unsigned value)
+{
+  return value < sizeof(names) / sizeof(names[0]) ? names[value] : "?";
+}
+
+// ================================================================================================================
+// TEXTO DE CADA EVENTO (OS DO STATUS, DATA E QUERY SEGUEM AS LINHAS QUE O FIRMWARE IMPRIMIA ANTES)
+// ================================================================================================================
+
+static void describe(const struct event_record *r)
+{
+  switch (r->id)
+  {
+  case EV_STATUS:
+    printf("%s - %u - %s", name(r->a >> 8), r->b, name(r->a & 0xff));
+    break;
+  case EV_UNICAST:
+    printf("DATA unicast from %u (%s)", r->a, name(r->b));
+    break;
+  case EV_QUERY:
+    printf("QUERY item %u -> %u", r->a, r->b);
+    break;
+  case EV_NACK_RETRY:
+    printf("DATA NACK item %u retry %u", r->a, r->b);
+    break;
+  case EV_NACK_BASE:
+    printf("DATA NACK item %u base %u", r->a, r->b);
+    break;
+  case EV_ERROR:
+    printf("DATA ERRO REPLICATION!!! from %u type %u", r->a, r->b);
+    break;
+  case EV_SUMMARY_IN:
+    printf("SUMMARY from %u: %u items, store %u", r->a, r->b >> 8, r->b & 0xff);
+    break;
+  case EV_SUMMARY_OUT:
+    printf("SUMMARY -> %u: %u items", r->a, r->b);
+    break;
+  case EV_STORED:
+    printf("DATA %u STORED (%u)", r->a, r->b);
+    break;
+  case EV_DATA:
+    printf("DATA %u -> %u v%u codec %u %u bytes", r->a >> 8, r->a & 0xff, r->b >> 8, (r->b >> 6) & 0x3, r->b & 0x3f);
+    break;
+  case EV_GET_STATUS:
+    printf("GET STATUS DATA %u -> %u", r->a, r->b);
+    break;
+  case EV_TIMEOUT:
+    printf("DATA TIMEOUT %u", r->a);
+    break;
+  case EV_RESEND:
+    printf("RESEND DATA %u x%u -> %u.%u", r->a >> 8, r->a & 0xff, r->b & 0xff, r->b >> 8);
+    break;
+  default:
+    printf("EVENTO %u %u %u", r->id, r->a, r->b);
+    break;
+  }
+}
+
+// ================================================================================================================
+
+static unsigned hex(const char *s, int digits)
+{
+  unsigned value = 0;
+
+  while (digits-- > 0)
+  {
+    value = value << 4 | (isdigit((unsigned char)*s) ? *s - '0' : tolower((unsigned char)*s) - 'a' + 10);
+    s++;
+  }
+
+  return value;
+}
+
+// RETORNA O INICIO DO REGISTRO NA LINHA OU NULL: 'E', 16 DIGITOS HEX E FIM DA LINHA
+
+static const char *find_record(const char *line)
+{
+  const char *s;
+  int i;
+
+  for (s = strchr(line, EVENT_LOG_PREFIX); s != NULL; s = strchr(s + 1, EVENT_LOG_PREFIX))
+  {
+    for (i = 1; i <= EVENT_LOG_LINE_DIGITS && isxdigit((unsigned char)s[i]); i++)
+      ;
+
+    if (i == EVENT_LOG_LINE_DIGITS + 1 && (s[i] == '\0' || s[i] == '\n' || s[i] == '\r'))
+    {
+      return s;
+    }
+  }
+
+  return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned clock_second = argc > 1 ? atoi(argv[1]) : 128;
+  char line[LINE_SIZE];
+  struct event_record r;
+  unsigned long records = 0, lost = 0;
+  const char *s;
+
+  while (fgets(line, sizeof(line), stdin) != NULL)
+  {
+    s = find_record(line);
+
+    if (s == NULL)
+    {
+      fputs(line, stdout);
+      continue;
+    }
+
+    r.id = hex(s + 1, 2);
+    r.lost = hex(s + 3, 2);
+    r.time = hex(s + 5, 4);
+    r.a = hex(s + 9, 4);
+    r.b = hex(s + 13, 4);
+
+    records++;
+    lost += r.lost;
+
+    fwrite(line, 1, s - line, stdout);
+
+    if (r.lost > 0)
+    {
+      printf("(%u eventos perdidos) ", r.lost);
+    }
+
+    printf("[%u.%03u] ", r.time / clock_second, r.time % clock_second * 1000 / clock_second);
+    describe(&r);
+    printf("\n");
+  }
+
+  fprintf(stderr, "%lu registros, %lu eventos perdidos\n", records, lost);
+
+  return 0;
+}
@@ -0,0 +1,132 @@
+// ================================================================================================================
+// LOG BINARIO DE EVENTOS
+//
+// O printf NO SKY ESPERA CADA BYTE SAIR PELA UART A 115200 BAUD: UMA LINHA DE STATUS PRENDE A CPU POR MAIS DE
+// 2 ms, E DENTRO DE UM CALLBACK DO RADIO ISSO ATRASA ACKS E O PROXIMO FRAME. AQUI O CALLBACK SO COPIA 8 BYTES
+// PARA O BUFFER; O event_log_process ESCREVE OS REGISTROS DEPOIS, EM LOTES CURTOS, CEDENDO A CPU ENTRE ELES.
+//
+// O PROCESSO E ACORDADO POR UM EVENTO NA FILA, NAO POR POLL: O POLL E ATENDIDO ANTES DOS EVENTOS PENDENTES,
+// ENQUANTO O EVENTO ESPERA OS QUE JA ESTAVAM NA FILA (RADIO, TIMERS).
+// ================================================================================================================
+
+#include "event-log.h"
+
+#include <stdio.h>
+
+#if EVENT_LOG_SIZE & (EVENT_LOG_SIZE - 1)
+#error "EVENT_LOG_SIZE deve ser potencia de 2"
+#endif
+
+static struct event_record records[EVENT_LOG_SIZE];
+static uint8_t head = 0;   // PROXIMO REGISTRO A SAIR
+static uint8_t length = 0; // REGISTROS PENDENTES
+
+static uint8_t pending_lost = 0;    // DESCARTES AINDA NAO ANOTADOS NUM REGISTRO
+static unsigned long total_lost = 0;
+
+static uint8_t scheduled = 0; // SAIDA JA PEDIDA AO PROCESSO
+
+PROCESS(event_log_process, "event log");
+
+// ================================================================================================================
+
+void event_log(uint8_t id, uint16_t a, uint16_t b)
+{
+  struct event_record *r;
+
+  // BUFFER CHEIO: DESCARTA O MAIS NOVO, PRESERVANDO A ORDEM DO QUE JA ESTA NA FILA
+  if (length == EVENT_LOG_SIZE)
+  {
+    total_lost++;
+
+    if (pending_lost < 255)
+    {
+      pending_lost++;
+    }
+    return;
+  }
+
+  r = &records[(head + length) & (EVENT_LOG_SIZE - 1)];
+  r->time = (uint16_t)clock_time();
+  r->id = id;
+  r->lost = pending_lost;
+  r->a = a;
+  r->b = b;
+
+  pending_lost = 0;
+  length++;
+
+  // COM A FILA DE EVENTOS CHEIA, O POLL GARANTE A SAIDA
+  if (!scheduled)
+  {
+    if (process_post(&event_log_process, PROCESS_EVENT_CONTINUE, NULL) != PROCESS_ERR_OK)
+    {
+      process_poll(&event_log_process);
+    }
+    scheduled = 1;
+  }
+}
+
+unsigned long event_log_lost(void)
+{
+  return total_lost;
+}
+
+// ================================================================================================================
+// SAIDA EM HEXADECIMAL COM putchar: SEM O PARSER DE FORMATO DO printf
+// ================================================================================================================
+
+static void put_hex(uint16_t value, int digits)
+{
+  static const char hex[] = "0123456789abcdef";
+
+  while (digits-- > 0)
+  {
+    putchar(hex[(value >> (digits * 4)) & 0xf]);
+  }
+}
+
+static void put_record(const struct event_record *r)
+{
+  putchar(EVENT_LOG_PREFIX);
+  put_hex(r->id, 2);
+  put_hex(r->lost, 2);
+  put_hex(r->time, 4);
+  put_hex(r->a, 4);
+  put_hex(r->b, 4);
+  putchar('\n');
+}
+
+// ================================================================================================================
+// PROCESSO DE SAIDA: ACORDA PELO EVENTO DE event_log() E ESCREVE NO MAXIMO EVENT_LOG_BURST REGISTROS POR VEZ
+// ================================================================================================================
+
+PROCESS_THREAD(event_log_process, ev, data)
+{
+  static int burst;
+
+  PROCESS_BEGIN();
+
+  while (1)
+  {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_CONTINUE || ev == PROCESS_EVENT_POLL);
+
+    while (length > 0)
+    {
+      for (burst = 0; burst < EVENT_LOG_BURST && length > 0; burst++)
+      {
+        put_record(&records[head]);
+
+        head = (head + 1) & (EVENT_LOG_SIZE - 1);
+        length--;
+      }
+
+      // DEIXA OS EVENTOS PENDENTES (RADIO, TIMERS) SEREM ATENDIDOS ANTES DO PROXIMO LOTE
+      PROCESS_PAUSE();
+    }
+
+    scheduled = 0;
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,74 @@
+// ================================================================================================================
+// LOG BINARIO DE EVENTOS: REGISTROS DE TAMANHO FIXO NUM BUFFER CIRCULAR EM RAM, ESVAZIADO PELA SERIAL POR UM
+// PROCESSO PROPRIO FORA DOS CALLBACKS DO RADIO. O event-log-decode (HOST) CONVERTE AS LINHAS DE VOLTA EM TEXTO.
+// ================================================================================================================
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <stdint.h>
+
+// NUMERO DE REGISTROS DO BUFFER (POTENCIA DE 2); CADA REGISTRO OCUPA 8 BYTES DE RAM
+#ifndef EVENT_LOG_SIZE
+#define EVENT_LOG_SIZE 32
+#endif
+
+// REGISTROS ESCRITOS NA SERIAL A CADA PASSADA DO PROCESSO, ANTES DE DEVOLVER A CPU AOS DEMAIS PROCESSOS
+#ifndef EVENT_LOG_BURST
+#define EVENT_LOG_BURST 4
+#endif
+
+// LINHA NA SERIAL: 'E' SEGUIDO DE id, lost, time, a E b EM HEXADECIMAL (2 + 2 + 4 + 4 + 4 DIGITOS)
+#define EVENT_LOG_PREFIX 'E'
+#define EVENT_LOG_LINE_DIGITS 16
+
+struct event_record
+{
+  uint16_t time; // clock_time() TRUNCADO EM 16 BITS (DA A VOLTA EM 65536 / CLOCK_SECOND SEGUNDOS)
+  uint8_t id;
+  uint8_t lost;  // REGISTROS DESCARTADOS COM O BUFFER CHEIO ANTES DESTE (SATURA EM 255)
+  uint16_t a;
+  uint16_t b;
+};
+
+// ================================================================================================================
+// EVENTOS DO FIRMWARE DE REPLICACAO (OS VALORES FAZEM PARTE DO FORMATO: NAO REORDENAR)
+// ================================================================================================================
+
+enum
+{
+  EV_STATUS = 1,  // a = ESTADO AGREGADO << 8 | CLASSIFICACAO, b = ESTABILIDADE
+  EV_UNICAST,     // a = REMETENTE, b = TIPO DA MENSAGEM
+  EV_QUERY,       // a = ITEM, b = DEVICE QUE GUARDA O ITEM (0 = DESCONHECIDO)
+  EV_NACK_RETRY,  // a = ITEM, b = INTERVALO SUGERIDO (s)
+  EV_NACK_BASE,   // a = ITEM, b = VERSAO BASE RECUSADA
+  EV_ERROR,       // a = REMETENTE, b = TIPO DA MENSAGEM
+  EV_SUMMARY_IN,  // a = LL DE ORIGEM, b = ITENS << 8 | TAMANHO DO REPOSITORIO
+  EV_SUMMARY_OUT, // a = DESTINO, b = ITENS
+  EV_STORED,      // a = ITEM, b = TAMANHO DO REPOSITORIO
+  EV_DATA,        // a = ITEM << 8 | DESTINO, b = VERSAO << 8 | CODEC << 6 | BYTES
+  EV_GET_STATUS,  // a = ITEM, b = DESTINO
+  EV_TIMEOUT,     // a = ITEM
+  EV_RESEND       // a = ITEM << 8 | TENTATIVA, b = DESTINO (u8[1] << 8 | u8[0])
+};
+
+// ================================================================================================================
+
+// O RESTO SO EXISTE NO FIRMWARE (O MAKEFILE DO CONTIKI DEFINE CONTIKI); O DECODIFICADOR USA APENAS O FORMATO
+
+#ifdef CONTIKI
+
+#include "contiki.h"
+
+// GRAVA UM REGISTRO E ACORDA O PROCESSO DE SAIDA; NAO BLOQUEIA. CHAMAR APENAS EM CONTEXTO DE PROCESSO (OS
+// CALLBACKS DO RIME RODAM NELE), NUNCA DE UMA INTERRUPCAO
+void event_log(uint8_t id, uint16_t a, uint16_t b);
+
+// TOTAL DE REGISTROS DESCARTADOS DESDE O BOOT
+unsigned long event_log_lost(void);
+
+PROCESS_NAME(event_log_process);
+
+#endif
+
+#endif
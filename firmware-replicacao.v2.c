@@ -11,8 +11,13 @@
 #include "dev/serial-line.h"
 #include "dev/leds.h"
 
+#include "replication-codec.h"
+#include "event-log.h"
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
 
 // ================================================================================================================
 // TIPOS DE DISPOTIVOS
@@ -32,7 +37,15 @@ enum
   SENDING_DATA,
   CONFIRM_DATA_OK,
   SENDING_STATUS,
-  GET_STATUS
+  GET_STATUS,
+  NACK_DATA,
+
+  QUERY_DATA,
+  QUERY_REPLY,
+  SENDING_SUMMARY,
+
+  NACK_BASE,  // BASE DO DELTA DIVERGENTE: O RECEPTOR TEM ESPACO, SO PRECISA DO ITEM COMPLETO
+  SUMMARY_ACK // LL CONFIRMA O RESUMO: item = LL DE ORIGEM, value = FIM DOS REGISTROS GRAVADOS
 };
 
 // ================================================================================================================
@@ -43,12 +56,72 @@ static int current_state = BEGIN;
 static int current_value_stability;
 static int current_value_attractiveness;
 
-static int authorized_replication = 0;
-static int numeroTentativas = 0;
-
-static rimeaddr_t last_neighbor_address;
 // static rimeaddr_t local_leader_address;
 
+// ================================================================================================================
+// TABELA DE ITENS DE DADOS REPLICADOS (UM ESTADO POR ITEM)
+// ================================================================================================================
+
+#define MAX_DATA_ITEMS 4
+#define MAX_TENTATIVAS 10
+
+// INTERVALO (S) SUGERIDO AO REMETENTE POR ITEM OCUPADO QUANDO A TABELA ESTA CHEIA
+#define RETRY_AFTER_POR_ITEM 4
+
+// LOG DE AMOSTRAS DO ITEM (BUFFER CIRCULAR DE int16_t) E USO DO CODEC (0 = SEMPRE CODEC_RAW)
+#define ITEM_PAYLOAD_SIZE 48
+#define REPLICATION_CODEC 1
+
+struct data_item
+{
+  int id; // 0 = POSICAO LIVRE
+  int state;
+  int authorized_replication;
+  int numeroTentativas;
+  rimeaddr_t peer; // ORIGEM (HAS_DATA) OU DESTINO (WAITING) DO ITEM
+
+  uint8_t version;      // 0 = SEM PAYLOAD
+  uint8_t base_version; // VERSAO ANTERIOR, BASE DO DELTA PARA VIZINHOS DESATUALIZADOS
+  uint8_t payload[ITEM_PAYLOAD_SIZE];
+  uint8_t base[ITEM_PAYLOAD_SIZE];
+};
+
+struct item_version
+{
+  uint8_t item;
+  uint8_t version;
+};
+
+static struct data_item data_items[MAX_DATA_ITEMS];
+
+// ================================================================================================================
+// REPOSITORIO DE REPLICAS DO LIDER LOCAL (APPEND-ONLY, SEM DUPLICATAS)
+// ================================================================================================================
+
+#define REPLICA_STORE_SIZE 32
+#define SUMMARY_MAX_ITEMS 8
+#define SUMMARY_INTERVAL 30
+
+struct replica_record
+{
+  uint8_t item;
+  uint8_t holder; // DEVICE QUE GUARDA O DADO (O PROPRIO LL OU UM LL A JUSANTE)
+};
+
+static struct replica_record replica_store[REPLICA_STORE_SIZE];
+static int replica_store_length = 0;
+static int summary_sent = 0; // REGISTROS JA CONFIRMADOS PELO LL A MONTANTE
+
+// ================================================================================================================
+// CONTADORES DO BENCHMARK (CONSULTADOS PELO SCRIPT COM "S")
+// ================================================================================================================
+
+static unsigned long frames_sent = 0; // FRAMES ENTREGUES AO MAC (UNICAST E BEACONS)
+static unsigned long frames_tx = 0;   // TRANSMISSOES NO RADIO, INCLUINDO RETRANSMISSOES DO MAC
+static unsigned long retries = 0;     // REENVIOS DE GET_STATUS POR FALTA DE CONFIRMACAO
+static unsigned long nacks = 0;       // NACK_DATA E NACK_BASE RECEBIDOS
+static unsigned long payload_bytes = 0; // BYTES DE PAYLOAD ENVIADOS EM SENDING_DATA
+
 // ================================================================================================================
 // ESTRUTURA DE MANIPULACAO DO PROCESSO DE BROADCAST ENVIO DE MENSAGENS BROADCAST
 // ================================================================================================================
@@ -61,12 +134,37 @@ struct message_broadcast
   int value_attractiveness;
   int value_stability;
   int type_node;
+  int free_capacity;
+  struct item_version held[MAX_DATA_ITEMS]; // VERSOES GUARDADAS, BASE DO DELTA DE QUEM ENVIA
 };
 
 struct message_unicast
 {
   int type;
   int value;
+  int item;
+
+  // APENAS EM SENDING_DATA; AS DEMAIS MENSAGENS SAO ENVIADAS COM MESSAGE_CONTROL_SIZE
+  uint8_t version;
+  uint8_t base_version;
+  uint8_t codec;
+  uint8_t length;
+  uint8_t data[ITEM_PAYLOAD_SIZE];
+};
+
+#define MESSAGE_CONTROL_SIZE offsetof(struct message_unicast, version)
+#define MESSAGE_DATA_SIZE(length) (offsetof(struct message_unicast, data) + (length))
+
+// RESUMO ENVIADO PELO LL AO VIZINHO MAIS ESTAVEL, QUE O REPASSA AO SEU LIDER LOCAL: ITENS GUARDADOS NO
+// REPOSITORIO DE ORIGEM
+
+struct message_summary
+{
+  int type;
+  int count;
+  uint8_t origin; // LL QUE GUARDA OS ITENS
+  uint8_t first;  // POSICAO DO PRIMEIRO ITEM NO REPOSITORIO DE ORIGEM
+  uint8_t items[SUMMARY_MAX_ITEMS];
 };
 
 struct neighbor
@@ -75,6 +173,9 @@ struct neighbor
   rimeaddr_t addr;
   int value_attractiveness;
   int value_stability;
+  int free_capacity;          // POSICOES LIVRES ANUNCIADAS NO ULTIMO BEACON
+  unsigned long retry_after;  // clock_seconds() A PARTIR DO QUAL O VIZINHO VOLTA A SER ALVO
+  struct item_version held[MAX_DATA_ITEMS];
 };
 
 static struct neighbor local_leader;
@@ -98,44 +199,51 @@ static struct etimer timout_FFL_process;
 // FUNCAO GERAL PARA VISUALIZACAO DE LOG
 // ================================================================================================================
 
-const char *get_classification()
-{
-  switch (current_classification)
-  {
-  case LL:
-    return "LL";
-  case LLN:
-    return "LLN";
-  case FLL:
-    return "FLL";
-  default:
-    return "";
-  }
-}
+// OS NOMES DE ESTADOS E CLASSIFICACOES FICAM NO event-log-decode (HOST); O ENUM ACIMA DEFINE OS VALORES
+
+// ESTADO AGREGADO DO DEVICE: HAS SE ALGUM ITEM ESTA EM HAS_DATA, WAITING SE ALGUM AGUARDA CONFIRMACAO
 
-const char *get_status()
+int get_aggregate_state()
 {
-  switch (current_state)
+  int i, state = current_state;
+
+  for (i = 0; i < MAX_DATA_ITEMS; i++)
   {
-  case HAS_DATA:
-    return "HAS";
-  case RUN:
-    return "RUN";
-  case WAITING:
-    return "WAITING";
-  default:
-    return "";
+    if (data_items[i].id == 0)
+    {
+      continue;
+    }
+
+    if (data_items[i].state == HAS_DATA)
+    {
+      return HAS_DATA;
+    }
+
+    if (data_items[i].state == WAITING)
+    {
+      state = WAITING;
+    }
   }
+
+  return state;
 }
 
+// O STATUS SO VAI PARA O LOG QUANDO MUDA: A LINHA ERA IMPRESSA A CADA BEACON RECEBIDO. DEPOIS DE REGISTROS
+// DESCARTADOS COM O BUFFER CHEIO ELE VAI DE NOVO, POIS UM DELES PODE TER SIDO A ULTIMA MUDANCA
+
 void show_log()
 {
-  if (current_state == HAS_DATA)
+  static uint16_t last_status = 0, last_stability = 0;
+  static unsigned long last_lost = 0;
+  int state = get_aggregate_state();
+  uint16_t status = state << 8 | current_classification;
+
+  if (state == HAS_DATA)
   {
     leds_on(LEDS_ALL);
   }
 
-  else if (current_state == WAITING)
+  else if (state == WAITING)
   {
     leds_off(LEDS_ALL);
     leds_on(LEDS_RED);
@@ -145,7 +253,171 @@ void show_log()
     leds_off(LEDS_ALL);
   }
 
-  printf("%s - %d - %s\n", get_status(), current_value_stability, get_classification());
+  if (status != last_status || current_value_stability != last_stability || event_log_lost() != last_lost)
+  {
+    last_status = status;
+    last_stability = current_value_stability;
+    last_lost = event_log_lost();
+    event_log(EV_STATUS, status, current_value_stability);
+  }
+}
+
+// ================================================================================================================
+// MANIPULACAO DA TABELA DE ITENS
+// ================================================================================================================
+
+// O ID 0 MARCA POSICAO LIVRE: NAO E UM ITEM E NUNCA E ENCONTRADO
+
+struct data_item *find_data_item(int id)
+{
+  int i;
+
+  if (id == 0)
+  {
+    return NULL;
+  }
+
+  for (i = 0; i < MAX_DATA_ITEMS; i++)
+  {
+    if (data_items[i].id == id)
+    {
+      return &data_items[i];
+    }
+  }
+
+  return NULL;
+}
+
+// POSICAO LIVRE OU COM ITEM JA REPASSADO (RUN), QUE PODE SER REAPROVEITADA
+
+struct data_item *find_free_data_item()
+{
+  int i;
+
+  for (i = 0; i < MAX_DATA_ITEMS; i++)
+  {
+    if (data_items[i].id == 0)
+    {
+      return &data_items[i];
+    }
+  }
+
+  for (i = 0; i < MAX_DATA_ITEMS; i++)
+  {
+    if (data_items[i].state == RUN)
+    {
+      return &data_items[i];
+    }
+  }
+
+  return NULL;
+}
+
+int get_free_capacity()
+{
+  int i, free = 0;
+
+  for (i = 0; i < MAX_DATA_ITEMS; i++)
+  {
+    if (data_items[i].id == 0 || data_items[i].state == RUN)
+    {
+      free++;
+    }
+  }
+
+  // O LL DESCARREGA OS ITENS NO REPOSITORIO, QUE PASSA A LIMITAR O QUE ELE ACEITA
+  if (current_classification == LL && REPLICA_STORE_SIZE - replica_store_length < free)
+  {
+    free = REPLICA_STORE_SIZE - replica_store_length;
+  }
+
+  return free;
+}
+
+// ================================================================================================================
+// MANIPULACAO DO REPOSITORIO DE REPLICAS
+// ================================================================================================================
+
+// RETORNA O DEVICE QUE GUARDA O ITEM (REGISTRO MAIS RECENTE) OU 0 QUANDO DESCONHECIDO. O PAYLOAD ARQUIVADO
+// PELO PROPRIO LL FICA NA POSICAO DA TABELA ATE ELA SER REAPROVEITADA: DAI EM DIANTE O LL NAO SE NOMEIA MAIS
+
+int replica_store_lookup(int item)
+{
+  int i;
+
+  for (i = replica_store_length - 1; i >= 0; i--)
+  {
+    if (replica_store[i].item != item)
+    {
+      continue;
+    }
+
+    if (replica_store[i].holder == rimeaddr_node_addr.u8[0] && find_data_item(item) == NULL)
+    {
+      continue;
+    }
+
+    return replica_store[i].holder;
+  }
+
+  return 0;
+}
+
+// RETORNA 0 QUANDO O REPOSITORIO ESTA CHEIO; UM REGISTRO REPETIDO NAO E GRAVADO NOVAMENTE
+
+int replica_store_append(int item, int holder)
+{
+  int i;
+
+  for (i = 0; i < replica_store_length; i++)
+  {
+    if (replica_store[i].item == item && replica_store[i].holder == holder)
+    {
+      return 1;
+    }
+  }
+
+  if (replica_store_length == REPLICA_STORE_SIZE)
+  {
+    return 0;
+  }
+
+  replica_store[replica_store_length].item = item;
+  replica_store[replica_store_length].holder = holder;
+  replica_store_length++;
+
+  return 1;
+}
+
+// RETORNA O ITEM JA EXISTENTE OU OCUPA UMA POSICAO LIVRE; NULL QUANDO A TABELA ESTA CHEIA OU O ID E 0
+
+struct data_item *alloc_data_item(int id)
+{
+  struct data_item *item;
+
+  if (id == 0)
+  {
+    return NULL;
+  }
+
+  item = find_data_item(id);
+
+  if (item == NULL)
+  {
+    item = find_free_data_item();
+
+    if (item != NULL)
+    {
+      item->id = id;
+      item->state = RUN;
+      item->authorized_replication = 0;
+      item->numeroTentativas = 0;
+      item->version = 0;
+      item->base_version = 0;
+    }
+  }
+
+  return item;
 }
 
 // ================================================================================================================
@@ -160,83 +432,421 @@ PROCESS(verification_FLL_process, "");
 PROCESS(script_process, "");
 
 PROCESS(replication_process, "");
+PROCESS(summary_process, "");
 
 AUTOSTART_PROCESSES(
     &broadcast_process,
     &script_process,
     &verification_LL_process,
     &verification_FLL_process,
-    &replication_process);
+    &replication_process,
+    &summary_process,
+    &event_log_process);
 
 // ================================================================================================================
 // METODO DE RECEBIMENTO DAS MENSAGENS DE UNICAST
 // ================================================================================================================
 
-static void response_unicast(struct unicast_conn *c, const rimeaddr_t *from)
+// SO O LL REGISTRA OS ITENS DO RESUMO, COMO GUARDADOS PELO LL DE ORIGEM. OS LIDERES NAO SAO VIZINHOS: QUEM NAO
+// E LL REPASSA AO SEU LIDER LOCAL O RESUMO RECEBIDO DIRETAMENTE DA ORIGEM. RESUMO DE QUEM NAO E VIZINHO
+// CONHECIDO E DESCARTADO
+
+static void receive_summary(struct message_summary *summary, const rimeaddr_t *from)
+{
+  struct message_unicast ack;
+  struct neighbor *n;
+  int i;
+
+  for (n = list_head(neighbors_list); n != NULL && !rimeaddr_cmp(&n->addr, from); n = list_item_next(n))
+    ;
+
+  if (n == NULL)
+  {
+    return;
+  }
+
+  if (current_classification != LL)
+  {
+    if (summary->origin == from->u8[0] && !rimeaddr_cmp(&local_leader.addr, &rimeaddr_null) &&
+        !rimeaddr_cmp(&local_leader.addr, from))
+    {
+      packetbuf_copyfrom(summary, sizeof(*summary));
+      unicast_send(&unicast_handler, &local_leader.addr);
+    }
+    return;
+  }
+
+  // SO CONFIRMA ATE O ULTIMO REGISTRO GRAVADO: COM O REPOSITORIO CHEIO, O RESTO VOLTA NO PROXIMO RESUMO
+  for (i = 0; i < summary->count && i < SUMMARY_MAX_ITEMS; i++)
+  {
+    if (!replica_store_append(summary->items[i], summary->origin))
+    {
+      break;
+    }
+  }
+
+  event_log(EV_SUMMARY_IN, summary->origin, summary->count << 8 | replica_store_length);
+
+  ack.type = SUMMARY_ACK;
+  ack.item = summary->origin;
+  ack.value = summary->first + i;
+
+  packetbuf_copyfrom(&ack, MESSAGE_CONTROL_SIZE);
+  unicast_send(&unicast_handler, from);
+}
+
+// A ORIGEM SO AVANCA O INICIO DO PROXIMO RESUMO COM A CONFIRMACAO; SEM ELA, A MESMA JANELA E REENVIADA. O
+// VIZINHO QUE REPASSOU O RESUMO REPASSA A CONFIRMACAO
+
+static void receive_summary_ack(struct message_unicast *ack)
+{
+  struct neighbor *n;
+
+  if (ack->item == rimeaddr_node_addr.u8[0])
+  {
+    if (ack->value > summary_sent && ack->value <= replica_store_length)
+    {
+      summary_sent = ack->value;
+    }
+    return;
+  }
+
+  for (n = list_head(neighbors_list); n != NULL && n->addr.u8[0] != ack->item; n = list_item_next(n))
+    ;
+
+  if (n != NULL)
+  {
+    packetbuf_copyfrom(ack, MESSAGE_CONTROL_SIZE);
+    unicast_send(&unicast_handler, &n->addr);
+  }
+}
+
+// VIZINHO SATURADO DEIXA DE SER ALVO ATE O PRAZO INDICADO NO NACK
+
+static void block_neighbor(const rimeaddr_t *addr, int retry_after)
+{
+  struct neighbor *n;
+
+  for (n = list_head(neighbors_list); n != NULL; n = list_item_next(n))
+  {
+    if (rimeaddr_cmp(&n->addr, addr))
+    {
+      n->free_capacity = 0;
+      n->retry_after = clock_seconds() + retry_after;
+    }
+  }
+
+  if (rimeaddr_cmp(&local_leader.addr, addr))
+  {
+    local_leader.free_capacity = 0;
+    local_leader.retry_after = clock_seconds() + retry_after;
+  }
+}
+
+// NOVO LIDER LOCAL NAO HERDA O BLOQUEIO NEM A CAPACIDADE ANUNCIADA PELO ANTERIOR
+
+static void set_local_leader(const rimeaddr_t *addr)
+{
+  if (rimeaddr_cmp(&local_leader.addr, addr))
+  {
+    return;
+  }
+
+  rimeaddr_copy(&local_leader.addr, addr);
+  local_leader.free_capacity = 0;
+  local_leader.retry_after = 0;
+}
+
+static int neighbor_accepts_data(struct neighbor *n)
+{
+  return n->free_capacity > 0 && clock_seconds() >= n->retry_after;
+}
+
+// ================================================================================================================
+// PAYLOAD DOS ITENS: DELTA CONTRA A VERSAO ANUNCIADA PELO RECEPTOR E COMPRESSAO
+// ================================================================================================================
+
+static int neighbor_item_version(struct neighbor *n, int id)
 {
-  printf("DATA unicast from %d\n", from->u8[0]);
+  int i;
 
+  for (i = 0; i < MAX_DATA_ITEMS; i++)
+  {
+    if (n->held[i].item == id)
+    {
+      return n->held[i].version;
+    }
+  }
+
+  return 0;
+}
+
+static void forget_neighbor_version(const rimeaddr_t *addr, int id)
+{
+  struct neighbor *n;
+  int i;
+
+  for (n = list_head(neighbors_list); n != NULL; n = list_item_next(n))
+  {
+    for (i = 0; i < MAX_DATA_ITEMS; i++)
+    {
+      if (rimeaddr_cmp(&n->addr, addr) && n->held[i].item == id)
+      {
+        n->held[i].item = 0;
+      }
+    }
+  }
+
+  for (i = 0; i < MAX_DATA_ITEMS; i++)
+  {
+    if (rimeaddr_cmp(&local_leader.addr, addr) && local_leader.held[i].item == id)
+    {
+      local_leader.held[i].item = 0;
+    }
+  }
+}
+
+// VERSOES EM ARITMETICA DE NUMERO DE SERIE (RFC 1982) SOBRE 8 BITS: A VOLTA DE 255 PARA 1 CONTINUA SENDO
+// "MAIS NOVA". 0 = SEM PAYLOAD, MAIS ANTIGA QUE QUALQUER VERSAO E NUNCA USADA NA VOLTA
+
+static int version_newer(uint8_t a, uint8_t b)
+{
+  if (a == 0)
+  {
+    return 0;
+  }
+
+  return b == 0 || (int8_t)(a - b) > 0;
+}
+
+static void encode_payload(struct message_unicast *msg, struct data_item *item, struct neighbor *n)
+{
+  int length, version = neighbor_item_version(n, item->id);
+
+  msg->version = item->version;
+  msg->base_version = 0;
+  msg->codec = CODEC_NONE;
+  msg->length = 0;
+
+  if (!version_newer(item->version, version))
+  {
+    return;
+  }
+
+#if REPLICATION_CODEC
+  if (version != 0 && version == item->base_version)
+  {
+    msg->base_version = version;
+    msg->codec = codec_encode(msg->data, ITEM_PAYLOAD_SIZE, &length, item->payload, item->base, ITEM_PAYLOAD_SIZE);
+  }
+  else
+  {
+    msg->codec = codec_encode(msg->data, ITEM_PAYLOAD_SIZE, &length, item->payload, NULL, ITEM_PAYLOAD_SIZE);
+  }
+
+  if (msg->codec != CODEC_DELTA_LZ)
+  {
+    msg->base_version = 0;
+  }
+#else
+  msg->codec = CODEC_RAW;
+  memcpy(msg->data, item->payload, ITEM_PAYLOAD_SIZE);
+  length = ITEM_PAYLOAD_SIZE;
+#endif
+
+  msg->length = length;
+  payload_bytes += length;
+}
+
+// RETORNA 0 QUANDO O FRAME NAO PODE SER APLICADO A VERSAO GUARDADA
+
+static int receive_payload(struct data_item *item, struct message_unicast *msg)
+{
+  static uint8_t payload[ITEM_PAYLOAD_SIZE];
+
+  // VERSAO IGUAL OU MAIS ANTIGA QUE A GUARDADA: NADA A APLICAR
+  if (!version_newer(msg->version, item->version))
+  {
+    return 1;
+  }
+
+  if (msg->codec == CODEC_NONE || (msg->codec == CODEC_DELTA_LZ && msg->base_version != item->version))
+  {
+    return 0;
+  }
+
+  if (codec_decode(payload, ITEM_PAYLOAD_SIZE, msg->codec, msg->data, msg->length, item->payload) != ITEM_PAYLOAD_SIZE)
+  {
+    return 0;
+  }
+
+  memcpy(item->base, item->payload, ITEM_PAYLOAD_SIZE);
+  item->base_version = item->version;
+
+  memcpy(item->payload, payload, ITEM_PAYLOAD_SIZE);
+  item->version = msg->version;
+
+  return 1;
+}
+
+// NOVA AMOSTRA NO LOG CIRCULAR DO ITEM; A VERSAO ANTERIOR FICA COMO BASE DO DELTA
+
+static void update_payload(struct data_item *item, int16_t sample)
+{
+  int16_t *log = (int16_t *)item->payload;
+
+  memcpy(item->base, item->payload, ITEM_PAYLOAD_SIZE);
+  item->base_version = item->version;
+
+  if (++item->version == 0)
+  {
+    item->version = 1;
+  }
+
+  log[item->version % (ITEM_PAYLOAD_SIZE / sizeof(int16_t))] = sample;
+}
+
+static void response_unicast(struct unicast_conn *c, const rimeaddr_t *from)
+{
   struct message_unicast *msg;
+  struct data_item *item;
   msg = packetbuf_dataptr();
 
+  event_log(EV_UNICAST, from->u8[0], msg->type);
+
+  item = (msg->type == SENDING_DATA) ? alloc_data_item(msg->item) : find_data_item(msg->item);
+
   switch (msg->type)
   {
 
+  case SENDING_SUMMARY:
+    receive_summary((struct message_summary *)msg, from);
+    break;
+
+  case SUMMARY_ACK:
+    receive_summary_ack(msg);
+    break;
+
+  case QUERY_DATA:
+
+    msg->type = QUERY_REPLY;
+    msg->value = (item != NULL && item->state == HAS_DATA) ? rimeaddr_node_addr.u8[0] : replica_store_lookup(msg->item);
+
+    packetbuf_copyfrom(msg, MESSAGE_CONTROL_SIZE);
+    unicast_send(c, from);
+    break;
+
+  case QUERY_REPLY:
+    event_log(EV_QUERY, msg->item, msg->value);
+    break;
+
   case SENDING_DATA:
 
-    current_state = HAS_DATA;
-    authorized_replication = 0;
+    if (item == NULL)
+    {
+      // BACKPRESSURE: RECUSA O ITEM E SUGERE QUANDO TENTAR NOVAMENTE
+      msg->type = NACK_DATA;
+      msg->value = RETRY_AFTER_POR_ITEM * (MAX_DATA_ITEMS - get_free_capacity());
+      event_log(EV_NACK_RETRY, msg->item, msg->value);
+
+      packetbuf_copyfrom(msg, MESSAGE_CONTROL_SIZE);
+      unicast_send(c, from);
+      break;
+    }
+
+    if (!receive_payload(item, msg))
+    {
+      // BASE DO DELTA DIFERENTE DA ANUNCIADA: O REMETENTE REENVIA COMPLETO NA PROXIMA TENTATIVA
+      msg->type = NACK_BASE;
+      msg->value = 0;
+      event_log(EV_NACK_BASE, msg->item, msg->base_version);
+
+      packetbuf_copyfrom(msg, MESSAGE_CONTROL_SIZE);
+      unicast_send(c, from);
+      break;
+    }
 
-    rimeaddr_copy(&last_neighbor_address, from);
+    item->state = HAS_DATA;
+    item->authorized_replication = 0;
+
+    rimeaddr_copy(&item->peer, from);
 
     msg->type = CONFIRM_DATA_OK;
-    packetbuf_copyfrom(msg, sizeof(struct message_unicast));
+    packetbuf_copyfrom(msg, MESSAGE_CONTROL_SIZE);
     unicast_send(c, from);
     break;
 
   case CONFIRM_DATA_OK:
-    current_state = RUN;
+    if (item != NULL)
+    {
+      item->state = RUN;
+    }
+    break;
+
+  case NACK_DATA:
+  case NACK_BASE:
+
+    nacks++;
+
+    // SO O NACK DE BACKPRESSURE BLOQUEIA O VIZINHO; O DE BASE PEDE APENAS O REENVIO COMPLETO
+    if (msg->type == NACK_DATA)
+    {
+      block_neighbor(from, msg->value);
+    }
+
+    forget_neighbor_version(from, msg->item);
+
+    if (item != NULL && item->state == WAITING)
+    {
+      item->state = HAS_DATA;
+      item->numeroTentativas = 0;
+    }
     break;
 
   case GET_STATUS:
 
     msg->type = SENDING_STATUS;
-    msg->value = current_state;
+    msg->value = (item != NULL) ? item->state : RUN;
 
-    packetbuf_copyfrom(msg, sizeof(struct message_unicast));
+    packetbuf_copyfrom(msg, MESSAGE_CONTROL_SIZE);
     unicast_send(c, from);
     break;
 
   case SENDING_STATUS:
 
-    if (msg->value == RUN && current_state == HAS_DATA)
+    if (item == NULL)
     {
-      authorized_replication = 1;
+      break;
     }
 
-    else if (msg->value == WAITING && current_state == HAS_DATA)
+    if (msg->value == RUN && item->state == HAS_DATA)
+    {
+      item->authorized_replication = 1;
+    }
+
+    else if (msg->value == WAITING && item->state == HAS_DATA)
     {
       msg->type = CONFIRM_DATA_OK;
-      packetbuf_copyfrom(msg, sizeof(struct message_unicast));
+      packetbuf_copyfrom(msg, MESSAGE_CONTROL_SIZE);
       unicast_send(c, from);
     }
 
-    else if (msg->value == HAS_DATA && current_state == WAITING)
+    else if (msg->value == HAS_DATA && item->state == WAITING)
     {
-      current_state = RUN;
-      authorized_replication = 0;
+      item->state = RUN;
+      item->authorized_replication = 0;
     }
 
-    else if (msg->value == RUN && current_state == WAITING)
+    else if (msg->value == RUN && item->state == WAITING)
     {
-      current_state = HAS_DATA;
-      authorized_replication = 1;
+      item->state = HAS_DATA;
+      item->authorized_replication = 1;
     }
 
     break;
 
   default:
-    printf("DATA ERRO REPLICATION!!!\n");
+    event_log(EV_ERROR, from->u8[0], msg->type);
     break;
   }
 
@@ -259,7 +869,7 @@ static void response_broadcast(struct broadcast_conn *c, const rimeaddr_t *from)
     if (m->type_node == LL)
     {
       current_classification = LLN;
-      rimeaddr_copy(&local_leader.addr, from);
+      set_local_leader(from);
 
       timer_restart(&timout_LL_process);
       timer_restart(&timout_FFL_process);
@@ -268,7 +878,7 @@ static void response_broadcast(struct broadcast_conn *c, const rimeaddr_t *from)
     if (m->type_node == LLN && current_classification == LL)
     {
       current_classification = LLN;
-      rimeaddr_copy(&local_leader.addr, from);
+      set_local_leader(from);
 
       timer_restart(&timout_LL_process);
       timer_restart(&timout_FFL_process);
@@ -277,6 +887,12 @@ static void response_broadcast(struct broadcast_conn *c, const rimeaddr_t *from)
 
   struct neighbor *n;
 
+  if (rimeaddr_cmp(&local_leader.addr, from))
+  {
+    local_leader.free_capacity = m->free_capacity;
+    memcpy(local_leader.held, m->held, sizeof(local_leader.held));
+  }
+
   // verifica se ja existe um vizinho com mesmo ip
   for (n = list_head(neighbors_list); n != NULL; n = list_item_next(n))
   {
@@ -298,17 +914,33 @@ static void response_broadcast(struct broadcast_conn *c, const rimeaddr_t *from)
     rimeaddr_copy(&n->addr, from);
     n->value_attractiveness = m->value_attractiveness;
     n->value_stability = m->value_stability;
+    n->retry_after = 0;
 
     list_add(neighbors_list, n);
   }
 
+  n->free_capacity = m->free_capacity;
+  memcpy(n->held, m->held, sizeof(n->held));
+
   show_log();
 }
 
 // ================================================================================================================
 
-static const struct unicast_callbacks unicast_call = {response_unicast};
-static const struct broadcast_callbacks broadcast_call = {response_broadcast};
+static void sent_unicast(struct unicast_conn *c, int status, int num_tx)
+{
+  frames_sent++;
+  frames_tx += num_tx;
+}
+
+static void sent_broadcast(struct broadcast_conn *c, int status, int num_tx)
+{
+  frames_sent++;
+  frames_tx += num_tx;
+}
+
+static const struct unicast_callbacks unicast_call = {response_unicast, sent_unicast};
+static const struct broadcast_callbacks broadcast_call = {response_broadcast, sent_broadcast};
 
 // ================================================================================================================
 // PROCESSO DE ENVIO DE MENSAGEM DE BROADCAST
@@ -317,6 +949,7 @@ static const struct broadcast_callbacks broadcast_call = {response_broadcast};
 PROCESS_THREAD(broadcast_process, ev, data)
 {
   static struct etimer et;
+  int i;
   PROCESS_EXITHANDLER(broadcast_close(&broadcast_handler);)
 
   PROCESS_BEGIN();
@@ -334,6 +967,13 @@ PROCESS_THREAD(broadcast_process, ev, data)
       msg.type_node = current_classification;
       msg.value_stability = current_value_stability;
       msg.value_attractiveness = current_value_attractiveness;
+      msg.free_capacity = get_free_capacity();
+
+      for (i = 0; i < MAX_DATA_ITEMS; i++)
+      {
+        msg.held[i].item = data_items[i].id;
+        msg.held[i].version = data_items[i].version;
+      }
 
       packetbuf_copyfrom(&msg, sizeof(msg));
       broadcast_send(&broadcast_handler);
@@ -424,124 +1064,168 @@ void rouletteWheelSelection(struct neighbor *n)
   }
 }
 
-PROCESS_THREAD(replication_process, ev, data)
+// ================================================================================================================
+// ATENDIMENTO DE UM ITEM DA TABELA; RETORNA 1 QUANDO UM FRAME FOI ENVIADO
+// ================================================================================================================
+
+static int service_data_item(struct data_item *item)
 {
+  int sum_fi, sum, r;
+  struct neighbor *n;
+  struct message_unicast msg;
 
-  PROCESS_EXITHANDLER(unicast_close(&unicast_handler));
-  PROCESS_BEGIN();
+  msg.item = item->id;
 
-  unicast_open(&unicast_handler, 146, &unicast_call);
+  if (item->state == HAS_DATA)
+  {
 
-  static struct etimer timer_replication;
-  static int timer_process = 15, randneighbor, i, sum_fi, sum, r;
-  static struct neighbor *n;
-  struct message_unicast msg;
+    if (item->authorized_replication == 1)
+    {
 
-  while (1)
-  {
+      switch (current_classification)
+      {
 
-    etimer_set(&timer_replication, CLOCK_SECOND * timer_process + random_rand() % (CLOCK_SECOND * timer_process));
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer_replication));
+      case FLL:
 
-    timer_process = 2;
+        sum_fi = 0;
+        sum = 0;
+        r = abs(random_rand() / 100);
 
-    if (list_length(neighbors_list) > 0)
-    {
+        // SOMENTE VIZINHOS COM CAPACIDADE LIVRE PARTICIPAM DA ROLETA
+        for (n = list_head(neighbors_list); n != NULL; n = list_item_next(n))
+        {
+          if (neighbor_accepts_data(n))
+          {
+            sum_fi += n->value_attractiveness + 1;
+          }
+        }
 
-      if (current_state == HAS_DATA)
-      {
+        if (sum_fi == 0)
+        {
+          return 0;
+        }
 
-        if (authorized_replication == 1)
+        for (n = list_head(neighbors_list); n != NULL; n = list_item_next(n))
         {
+          if (!neighbor_accepts_data(n))
+          {
+            continue;
+          }
 
-          switch (current_classification)
+          sum += ((n->value_attractiveness + 1) / sum_fi);
+
+          if (sum > r)
           {
+            break;
+          }
+        }
 
-          case FLL:
+        if (n == NULL)
+        {
+          for (n = list_head(neighbors_list); !neighbor_accepts_data(n); n = list_item_next(n))
+            ;
+        }
+        break;
 
-            sum_fi = 0;
-            sum = 0;
-            r = abs(random_rand() / 100);
+      case LLN:
+        n = &local_leader;
 
-            for (n = list_head(neighbors_list); n != NULL; n = list_item_next(n))
-            {
-              sum_fi += n->value_attractiveness;
-            }
+        if (!neighbor_accepts_data(n))
+        {
+          return 0;
+        }
+        break;
 
-            for (n = list_head(neighbors_list); n != NULL; n = list_item_next(n))
-            {
-              sum += (n->value_attractiveness / sum_fi);
+      case LL:
 
-              if (sum > r)
-              {
-                break;
-              }
-            }
+        // O LL ARQUIVA O ITEM NO REPOSITORIO; O PAYLOAD CONTINUA NA POSICAO (RUN) ATE OUTRO ITEM PRECISAR DELA
+        if (replica_store_append(item->id, rimeaddr_node_addr.u8[0]))
+        {
+          item->state = RUN;
+          event_log(EV_STORED, item->id, replica_store_length);
+        }
+        return 0;
 
-            if (n == NULL)
-            {
-              n = list_head(neighbors_list);
-            }
+      default:
+        return 0;
+      }
 
-            msg.type = SENDING_DATA;
-            current_state = WAITING;
-            printf("DATA -> %d\n", n->addr.u8[0]);
+      msg.type = SENDING_DATA;
+      item->state = WAITING;
+      rimeaddr_copy(&item->peer, &n->addr);
+      encode_payload(&msg, item, n);
+      event_log(EV_DATA, item->id << 8 | n->addr.u8[0], msg.version << 8 | msg.codec << 6 | msg.length);
 
-            packetbuf_copyfrom(&msg, sizeof(msg));
-            unicast_send(&unicast_handler, &n->addr);
-            break;
+      packetbuf_copyfrom(&msg, MESSAGE_DATA_SIZE(msg.length));
+      unicast_send(&unicast_handler, &n->addr);
+      return 1;
+    }
 
-          case LLN:
+    msg.type = GET_STATUS;
+    event_log(EV_GET_STATUS, item->id, item->peer.u8[0]);
 
-            n = &local_leader;
+    packetbuf_copyfrom(&msg, MESSAGE_CONTROL_SIZE);
+    unicast_send(&unicast_handler, &item->peer);
+    return 1;
+  }
 
-            msg.type = SENDING_DATA;
-            current_state = WAITING;
-            printf("DATA -> %d\n", n->addr.u8[0]);
+  if (item->state == WAITING)
+  {
 
-            packetbuf_copyfrom(&msg, sizeof(msg));
-            unicast_send(&unicast_handler, &n->addr);
+    if (item->numeroTentativas == MAX_TENTATIVAS)
+    {
+      item->state = HAS_DATA;
+      item->numeroTentativas = 0;
+      event_log(EV_TIMEOUT, item->id, 0);
+      return 0;
+    }
 
-            break;
+    event_log(EV_RESEND, item->id << 8 | item->numeroTentativas, item->peer.u8[1] << 8 | item->peer.u8[0]);
+    item->numeroTentativas++;
+    retries++;
 
-          case LL:
-            break;
+    msg.type = GET_STATUS;
 
-          default:
-            break;
-          }
-        }
+    packetbuf_copyfrom(&msg, MESSAGE_CONTROL_SIZE);
+    unicast_send(&unicast_handler, &item->peer);
+    return 1;
+  }
 
-        else
-        {
-          msg.type = GET_STATUS;
-          printf("GET STATUS DATA-> %d\n", last_neighbor_address.u8[0]);
+  return 0;
+}
 
-          packetbuf_copyfrom(&msg, sizeof(msg));
-          unicast_send(&unicast_handler, &last_neighbor_address);
-        }
-      }
+// ================================================================================================================
+// PROCESSO DE REPLICACAO: UM UNICO LACO ATENDE TODOS OS ITENS DA TABELA
+// ================================================================================================================
 
-      else if (current_state == WAITING)
-      {
+PROCESS_THREAD(replication_process, ev, data)
+{
 
-        if (numeroTentativas == 10)
-        {
-          current_state = HAS_DATA;
-          numeroTentativas = 0;
-          printf("DATA TIMEOUT\n");
-        }
+  PROCESS_EXITHANDLER(unicast_close(&unicast_handler));
+  PROCESS_BEGIN();
 
-        else
-        {
+  unicast_open(&unicast_handler, 146, &unicast_call);
+
+  static struct etimer timer_replication;
+  static int timer_process = 15, i;
 
-          printf("RESEND DATA x%d -> %d.%d\n", numeroTentativas, n->addr.u8[0], n->addr.u8[1]);
-          numeroTentativas++;
+  while (1)
+  {
 
-          msg.type = GET_STATUS;
+    etimer_set(&timer_replication, CLOCK_SECOND * timer_process + random_rand() % (CLOCK_SECOND * timer_process));
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer_replication));
 
-          packetbuf_copyfrom(&msg, sizeof(msg));
-          unicast_send(&unicast_handler, &n->addr);
+    timer_process = 2;
+
+    if (list_length(neighbors_list) > 0)
+    {
+
+      for (i = 0; i < MAX_DATA_ITEMS; i++)
+      {
+        if (data_items[i].id != 0 && service_data_item(&data_items[i]))
+        {
+          // LIBERA O MAC ANTES DO PROXIMO FRAME
+          PROCESS_PAUSE();
         }
       }
     }
@@ -551,12 +1235,75 @@ PROCESS_THREAD(replication_process, ev, data)
   PROCESS_END();
 }
 
+// ================================================================================================================
+// PROCESSO DE ENVIO DO RESUMO DO REPOSITORIO AO VIZINHO MAIS ESTAVEL (UPSTREAM)
+// ================================================================================================================
+
+PROCESS_THREAD(summary_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  static struct etimer timer_summary;
+  struct message_summary summary;
+  struct neighbor *n, *upstream;
+  int i;
+
+  while (1)
+  {
+
+    etimer_set(&timer_summary, CLOCK_SECOND * SUMMARY_INTERVAL + random_rand() % (CLOCK_SECOND * SUMMARY_INTERVAL));
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer_summary));
+
+    if (current_classification != LL || replica_store_length == summary_sent)
+    {
+      continue;
+    }
+
+    upstream = NULL;
+
+    for (n = list_head(neighbors_list); n != NULL; n = list_item_next(n))
+    {
+      if (n->value_stability > current_value_stability &&
+          (upstream == NULL || n->value_stability > upstream->value_stability))
+      {
+        upstream = n;
+      }
+    }
+
+    if (upstream == NULL)
+    {
+      continue;
+    }
+
+    // APENAS OS REGISTROS AINDA NAO CONFIRMADOS, NO MAXIMO SUMMARY_MAX_ITEMS POR FRAME
+    summary.type = SENDING_SUMMARY;
+    summary.count = 0;
+    summary.origin = rimeaddr_node_addr.u8[0];
+    summary.first = summary_sent;
+
+    for (i = summary_sent; i < replica_store_length && summary.count < SUMMARY_MAX_ITEMS; i++)
+    {
+      summary.items[summary.count++] = replica_store[i].item;
+    }
+
+    event_log(EV_SUMMARY_OUT, upstream->addr.u8[0], summary.count);
+
+    packetbuf_copyfrom(&summary, sizeof(summary));
+    unicast_send(&unicast_handler, &upstream->addr);
+  }
+
+  PROCESS_END();
+}
+
 // ================================================================================================================
 // SCRIPT DE INICIALIZACAO DOS DEVICES
 // ================================================================================================================
 
 PROCESS_THREAD(script_process, ev, data)
 {
+  static struct data_item *item;
+  unsigned int i;
+
   PROCESS_BEGIN();
   PROCESS_YIELD_UNTIL(ev == serial_line_event_message);
 
@@ -564,19 +1311,64 @@ PROCESS_THREAD(script_process, ev, data)
   current_value_attractiveness = abs(random_rand() / 100);
 
   current_classification = LL;
+  current_state = RUN;
 
-  if (atoi((char *)data) == 1)
-  {
-    current_state = HAS_DATA;
-    authorized_replication = 1;
-  }
-  else
+  // O VALOR RECEBIDO E O IDENTIFICADOR DO ITEM SEMEADO NESTE DEVICE (0 = NENHUM)
+  item = alloc_data_item(atoi((char *)data));
+
+  if (item != NULL)
   {
-    current_state = RUN;
-    authorized_replication = 0;
+    item->state = HAS_DATA;
+    item->authorized_replication = 1;
+
+    for (i = 0; i < ITEM_PAYLOAD_SIZE / sizeof(int16_t); i++)
+    {
+      update_payload(item, random_rand() % 1024);
+    }
   }
 
   show_log();
 
+  // CONSULTAS POSTERIORES: "Q<item>" PERGUNTA AO LIDER LOCAL QUEM GUARDA O ITEM; "S" IMPRIME OS CONTADORES
+  // (O ULTIMO E O DE REGISTROS DE LOG DESCARTADOS)
+  while (1)
+  {
+    PROCESS_YIELD_UNTIL(ev == serial_line_event_message);
+
+    // "U<item>": NOVA LEITURA DE SENSOR NO ITEM, SE ESTE DEVICE O GUARDA
+    if (((char *)data)[0] == 'U')
+    {
+      item = find_data_item(atoi((char *)data + 1));
+
+      if (item != NULL && item->state == HAS_DATA)
+      {
+        int16_t *log = (int16_t *)item->payload;
+        update_payload(item, log[item->version % (ITEM_PAYLOAD_SIZE / sizeof(int16_t))] + random_rand() % 8);
+      }
+    }
+
+    if (((char *)data)[0] == 'S')
+    {
+      printf("STATS %lu %lu %lu %lu %lu %lu\n", frames_sent, frames_tx, retries, nacks, payload_bytes, event_log_lost());
+    }
+
+    if (((char *)data)[0] == 'Q')
+    {
+      struct message_unicast query;
+      query.type = QUERY_DATA;
+      query.item = atoi((char *)data + 1);
+      query.value = 0;
+
+      if (current_classification == LL)
+      {
+        event_log(EV_QUERY, query.item, replica_store_lookup(query.item));
+        continue;
+      }
+
+      packetbuf_copyfrom(&query, MESSAGE_CONTROL_SIZE);
+      unicast_send(&unicast_handler, &local_leader.addr);
+    }
+  }
+
   PROCESS_END();
 }
\ No newline at end of file
@@ -0,0 +1,226 @@
+// ================================================================================================================
+// CODEC DE PAYLOAD DA REPLICACAO
+//
+// LZSS NO ESTILO DO HEATSHRINK, MAS ORIENTADO A BYTE: CADA BYTE DE FLAGS PRECEDE 8 TOKENS (BIT 1 = MATCH).
+// A JANELA E O PROPRIO BUFFER DE ENTRADA, ENTAO NAO HA ESTADO NEM RAM EXTRA NO MSP430.
+// ================================================================================================================
+
+#include "replication-codec.h"
+
+#include <string.h>
+
+int codec_compress(uint8_t *out, int out_size, const uint8_t *in, int len)
+{
+  int pos = 0, out_len = 0, flags_pos = 0, token = 8;
+
+  while (pos < len)
+  {
+    int best_len = 0, best_dist = 0, start, i;
+
+    if (token == 8)
+    {
+      if (out_len >= out_size)
+      {
+        return -1;
+      }
+
+      flags_pos = out_len++;
+      out[flags_pos] = 0;
+      token = 0;
+    }
+
+    start = pos > CODEC_WINDOW ? pos - CODEC_WINDOW : 0;
+
+    for (i = start; i < pos; i++)
+    {
+      int n = 0;
+
+      while (n < CODEC_MAX_MATCH && pos + n < len && in[i + n] == in[pos + n])
+      {
+        n++;
+      }
+
+      if (n > best_len)
+      {
+        best_len = n;
+        best_dist = pos - i;
+      }
+    }
+
+    if (best_len >= CODEC_MIN_MATCH)
+    {
+      if (out_len + 2 > out_size)
+      {
+        return -1;
+      }
+
+      out[flags_pos] |= 1 << token;
+      out[out_len++] = (uint8_t)(best_dist >> 4);
+      out[out_len++] = (uint8_t)(((best_dist & 0x0f) << 4) | (best_len - CODEC_MIN_MATCH));
+      pos += best_len;
+    }
+    else
+    {
+      if (out_len >= out_size)
+      {
+        return -1;
+      }
+
+      out[out_len++] = in[pos++];
+    }
+
+    token++;
+  }
+
+  return out_len;
+}
+
+int codec_decompress(uint8_t *out, int out_size, const uint8_t *in, int len)
+{
+  int pos = 0, out_len = 0, token = 8;
+  uint8_t flags = 0;
+
+  while (pos < len)
+  {
+    if (token == 8)
+    {
+      flags = in[pos++];
+      token = 0;
+      continue;
+    }
+
+    if (flags & (1 << token))
+    {
+      int dist, n;
+
+      if (pos + 2 > len)
+      {
+        return -1;
+      }
+
+      dist = (in[pos] << 4) | (in[pos + 1] >> 4);
+      n = (in[pos + 1] & 0x0f) + CODEC_MIN_MATCH;
+      pos += 2;
+
+      if (dist == 0 || dist > out_len || out_len + n > out_size)
+      {
+        return -1;
+      }
+
+      // COPIA BYTE A BYTE: O MATCH PODE SOBREPOR A PROPRIA SAIDA
+      while (n-- > 0)
+      {
+        out[out_len] = out[out_len - dist];
+        out_len++;
+      }
+    }
+    else
+    {
+      if (out_len >= out_size)
+      {
+        return -1;
+      }
+
+      out[out_len++] = in[pos++];
+    }
+
+    token++;
+  }
+
+  return out_len;
+}
+
+void codec_xor(uint8_t *out, const uint8_t *a, const uint8_t *b, int len)
+{
+  int i;
+
+  for (i = 0; i < len; i++)
+  {
+    out[i] = a[i] ^ b[i];
+  }
+}
+
+int codec_encode(uint8_t *out, int out_size, int *out_len, const uint8_t *data, const uint8_t *base, int len)
+{
+  static uint8_t delta[CODEC_MAX_PAYLOAD];
+  int n, codec = CODEC_RAW;
+
+  *out_len = len;
+
+  if (base != NULL && len <= CODEC_MAX_PAYLOAD)
+  {
+    codec_xor(delta, data, base, len);
+    n = codec_compress(out, out_size, delta, len);
+
+    if (n >= 0 && n < *out_len)
+    {
+      *out_len = n;
+      codec = CODEC_DELTA_LZ;
+    }
+  }
+
+  n = codec_compress(out, out_size, data, len);
+
+  if (n >= 0 && n < *out_len)
+  {
+    *out_len = n;
+    codec = CODEC_LZ;
+  }
+  else if (codec == CODEC_DELTA_LZ)
+  {
+    // O DELTA FOI MELHOR: REFAZ A SAIDA SOBRESCRITA PELA TENTATIVA SEM DELTA
+    codec_compress(out, out_size, delta, len);
+  }
+
+  if (codec == CODEC_RAW)
+  {
+    if (len > out_size)
+    {
+      return -1;
+    }
+
+    memcpy(out, data, len);
+  }
+
+  return codec;
+}
+
+int codec_decode(uint8_t *data, int data_size, int codec, const uint8_t *in, int in_len, const uint8_t *base)
+{
+  int n;
+
+  switch (codec)
+  {
+  case CODEC_RAW:
+
+    if (in_len > data_size)
+    {
+      return -1;
+    }
+
+    memcpy(data, in, in_len);
+    return in_len;
+
+  case CODEC_LZ:
+    return codec_decompress(data, data_size, in, in_len);
+
+  case CODEC_DELTA_LZ:
+
+    if (base == NULL)
+    {
+      return -1;
+    }
+
+    n = codec_decompress(data, data_size, in, in_len);
+
+    if (n > 0)
+    {
+      codec_xor(data, data, base, n);
+    }
+
+    return n;
+
+  default:
+    return -1;
+  }
+}
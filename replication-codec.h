@@ -0,0 +1,43 @@
+// ================================================================================================================
+// CODEC DE PAYLOAD DA REPLICACAO: DELTA (XOR) CONTRA A VERSAO DO RECEPTOR + LZSS SEM JANELA PROPRIA
+// ================================================================================================================
+
+#ifndef REPLICATION_CODEC_H
+#define REPLICATION_CODEC_H
+
+#include <stdint.h>
+
+enum
+{
+  CODEC_NONE,     // SEM PAYLOAD (RECEPTOR JA POSSUI A VERSAO ATUAL)
+  CODEC_RAW,      // PAYLOAD SEM COMPRESSAO
+  CODEC_LZ,       // PAYLOAD COMPRIMIDO
+  CODEC_DELTA_LZ  // XOR CONTRA A VERSAO DO RECEPTOR, COMPRIMIDO
+};
+
+// MATCH = 2 BYTES: DISTANCIA DE 12 BITS E COMPRIMENTO DE 4 BITS (CODEC_MIN_MATCH..CODEC_MIN_MATCH + 15)
+#define CODEC_MIN_MATCH 3
+#define CODEC_MAX_MATCH (CODEC_MIN_MATCH + 15)
+#define CODEC_WINDOW 4095
+
+// MAIOR PAYLOAD QUE O codec_encode CONSIDERA PARA DELTA (BUFFER ESTATICO)
+#ifndef CODEC_MAX_PAYLOAD
+#define CODEC_MAX_PAYLOAD 64
+#endif
+
+// COMPRIME len BYTES DE in; RETORNA O TAMANHO GERADO OU -1 SE NAO COUBER EM out_size
+int codec_compress(uint8_t *out, int out_size, const uint8_t *in, int len);
+
+// RETORNA O TAMANHO DESCOMPRIMIDO OU -1 SE O FLUXO FOR INVALIDO OU NAO COUBER EM out_size
+int codec_decompress(uint8_t *out, int out_size, const uint8_t *in, int len);
+
+// out = a XOR b (out PODE SER a OU b)
+void codec_xor(uint8_t *out, const uint8_t *a, const uint8_t *b, int len);
+
+// ESCOLHE O MENOR FORMATO PARA data; base PODE SER NULL. RETORNA O CODEC E GRAVA O TAMANHO EM *out_len
+int codec_encode(uint8_t *out, int out_size, int *out_len, const uint8_t *data, const uint8_t *base, int len);
+
+// RECONSTROI data A PARTIR DO FRAME; base E EXIGIDO POR CODEC_DELTA_LZ. RETORNA O TAMANHO OU -1
+int codec_decode(uint8_t *data, int data_size, int codec, const uint8_t *in, int in_len, const uint8_t *base);
+
+#endif